@@ -1,11 +1,20 @@
 #pragma once
 
-#include <iostream>  // For debugging
-#include <sstream>   // For as_string
+#include <atomic>      // For the parallel helpers
+#include <cstdint>     // For the content hash
+#include <functional>  // For the parallel helpers and hash
+#include <iostream>    // For debugging
+#include <sstream>     // For as_string
+#include <thread>      // For the parallel helpers
+#include <vector>      // For the parallel helpers
 
 using namespace std;
 
-template <typename T>
+// With `Hashed` set, the queue also keeps a hash of its contents (see
+// `content_hash`), which costs a hash per enqueue and dequeue and lets most
+// unequal queues of the same size compare unequal in O(1). `T` must then
+// have a `std::hash`.
+template <typename T, bool Hashed = false>
 class prqueue {
 private:
     struct NODE {
@@ -20,39 +29,36 @@ private:
     NODE* root;
     size_t sz;
 
+    // Sum of elementHash over every element, kept up to date by enqueue and
+    // dequeue so that most unequal queues are told apart without a walk.
+    // Always 0 unless `Hashed` is set.
+    size_t contentHash;
+    static_assert(!Hashed || requires(const T& value) { hash<T>{}(value); }, "prqueue<T, true> needs std::hash<T>");
+
     // Utility pointers for begin and next.
     NODE* curr;
     NODE* temp;
 
+    // Copies `node` and its duplicate list, but not its children
+    NODE* copyNode(NODE* node, NODE* parent) {
+        NODE* newNode = new NODE{ node->priority, node->value, parent, nullptr, nullptr, nullptr };
+
+        NODE* newLinkNode = newNode;
+        for (NODE* oldLinkNode = node->link; oldLinkNode != nullptr; oldLinkNode = oldLinkNode->link) { //Copy over the linked nodes for dupes
+            newLinkNode->link = new NODE{ oldLinkNode->priority, oldLinkNode->value, nullptr, nullptr, nullptr, nullptr };
+            newLinkNode = newLinkNode->link;
+        }
+        return newNode;
+    }
+
     NODE* cpy(NODE* node, NODE* parent = nullptr) {
         if (node == nullptr) { 
             return nullptr;
         }
 
-        NODE* newNode = new NODE; 
-        newNode->value = node->value;
-        newNode->priority = node->priority;
-        newNode->parent = parent;
-
+        NODE* newNode = copyNode(node, parent);
         newNode->right = cpy(node->right, newNode);  
         newNode->left = cpy(node->left, newNode); 
-        
-        if (node->link != nullptr) { //Copy over the linked nodes for dupes
-            NODE* newLinkNode = newNode;
-            NODE* oldLinkNode = node->link;
-
-            while (oldLinkNode != nullptr) { //Loop to make new nodes with same values and priorities
-                NODE* newerLinkNode = new NODE;
-                newerLinkNode->value = oldLinkNode->value;
-                newerLinkNode->priority = oldLinkNode->priority;
-
-                newLinkNode->link = newerLinkNode; //Add the new node to the linked list 
-
-                newLinkNode = newLinkNode->link;
-                oldLinkNode = oldLinkNode->link; //Iterate to the next node in the list
-            }
-            newLinkNode->link = nullptr; //set last node to nullptr 
-        }
         return newNode;
     }
 
@@ -107,19 +113,158 @@ private:
         delete node;  
     }
 
-    bool equal(NODE* og, NODE* copy) const { //==operator helper
+    static size_t elementHash(const T& value, int priority) {
+        if constexpr (Hashed) {
+            uint64_t h = hash<T>{}(value) ^ ((uint64_t)(unsigned)priority * 0x9E3779B97F4A7C15ULL);
+            h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL; //splitmix64 finalizer, so the sum does not cancel out
+            h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+            return (size_t)(h ^ (h >> 31));
+        }
+        else {
+            return 0;
+        }
+    }
+
+    // Compares one node and its duplicate list, but not its children
+    static bool equalNode(NODE* og, NODE* copy) {
+        while (og != nullptr && copy != nullptr) {
+            if (og->priority != copy->priority || og->value != copy->value) {
+                return false;
+            }
+            og = og->link;
+            copy = copy->link;
+        }
+        return og == copy; //both lists ended together
+    }
+
+    bool equal(NODE* og, NODE* copy) const { //==operator helper, iterative so deep trees cannot overflow the stack
+        vector<pair<NODE*, NODE*>> pending;
+        pending.emplace_back(og, copy);
+        while (!pending.empty()) {
+            og = pending.back().first;
+            copy = pending.back().second;
+            pending.pop_back();
+
+            if (og == nullptr && copy == nullptr) {
+                continue;
+            }
+            if (og == nullptr || copy == nullptr) {
+                return false;
+            }
+            if (!equalNode(og, copy)) {
+                return false;
+            }
+            pending.emplace_back(og->left, copy->left);
+            pending.emplace_back(og->right, copy->right);
+        }
+        return true;
+    }
+
+    // Runs `tasks` on up to `threads` threads (0 = one per core), each thread taking the next unstarted task
+    static void runParallel(vector<function<void()>>& tasks, unsigned threads) {
+        if (threads == 0) {
+            threads = thread::hardware_concurrency();
+        }
+        if (threads > tasks.size()) {
+            threads = (unsigned)tasks.size();
+        }
+        atomic<size_t> nextTask{0};
+        auto worker = [&tasks, &nextTask] {
+            for (size_t i = nextTask++; i < tasks.size(); i = nextTask++) {
+                tasks[i]();
+            }
+        };
+
+        vector<thread> pool;
+        for (unsigned i = 1; i < threads; i++) {
+            pool.emplace_back(worker);
+        }
+        worker(); //the calling thread works too
+        for (thread& t : pool) {
+            t.join();
+        }
+    }
+
+    // How many levels to walk serially before handing subtrees to threads;
+    // about four subtrees per thread so uneven subtrees still balance out
+    static int splitDepth(unsigned threads) {
+        if (threads == 0) {
+            threads = thread::hardware_concurrency();
+        }
+        int depth = 2;
+        while ((1u << depth) < threads * 4 && depth < 16) {
+            depth++;
+        }
+        return depth;
+    }
+
+    // Lists the top `depth` levels in order: each entry is either a single top
+    // node (true) or a whole subtree below them (false)
+    static void split(NODE* node, int depth, vector<pair<NODE*, bool>>& pieces) {
+        if (node == nullptr) {
+            return;
+        }
+        if (depth == 0) {
+            pieces.emplace_back(node, false);
+            return;
+        }
+        split(node->left, depth - 1, pieces);
+        pieces.emplace_back(node, true);
+        split(node->right, depth - 1, pieces);
+    }
+
+    // A subtree below the serially copied top levels, to be copied by a thread
+    struct COPYJOB {
+        NODE* node;
+        NODE* parent;
+        NODE** dest;
+    };
+
+    // Copies the top `depth` levels and records the subtrees below them in `jobs`
+    void cpyTop(NODE* node, NODE* parent, NODE** dest, int depth, vector<COPYJOB>& jobs) {
+        *dest = nullptr;
+        if (node == nullptr) {
+            return;
+        }
+        if (depth == 0) {
+            jobs.push_back(COPYJOB{ node, parent, dest });
+            return;
+        }
+        NODE* newNode = copyNode(node, parent);
+        *dest = newNode;
+        cpyTop(node->left, newNode, &newNode->left, depth - 1, jobs);
+        cpyTop(node->right, newNode, &newNode->right, depth - 1, jobs);
+    }
+
+    // Compares the top `depth` levels and records the subtree pairs below them in `jobs`
+    bool equalTop(NODE* og, NODE* copy, int depth, vector<pair<NODE*, NODE*>>& jobs) const {
         if (og == nullptr && copy == nullptr) {
             return true;
         }
-        if (og == nullptr || copy == nullptr)
-        {
-            return false; 
+        if (og == nullptr || copy == nullptr) {
+            return false;
         }
-
-        if (og->priority != copy->priority || og->value != copy->value) {
+        if (depth == 0) {
+            jobs.emplace_back(og, copy);
+            return true;
+        }
+        if (!equalNode(og, copy)) {
             return false;
         }
-        return equal(og->right, copy->right) && equal(og->left, copy->left);
+        return equalTop(og->right, copy->right, depth - 1, jobs) && equalTop(og->left, copy->left, depth - 1, jobs);
+    }
+
+    // Finishes an unfinished begin()/next() traversal so the threaded links are undone
+    // Called before anything changes or frees nodes, so `curr` and `temp` never point at freed nodes
+    void finishTraversal() {
+        if (curr != nullptr || temp != nullptr) {
+            T value;
+            int priority;
+            while (next(value, priority)) {
+            }
+        }
+        curr = nullptr;
+        temp = nullptr;
     }
 
 public:
@@ -128,6 +273,7 @@ public:
     prqueue() {
         root = nullptr;
         sz = 0;
+        contentHash = 0;
         curr = nullptr;
         temp = nullptr;
     }
@@ -138,6 +284,9 @@ public:
 
         root = cpy(other.root);
         sz = other.sz;
+        contentHash = other.contentHash;
+        curr = nullptr;
+        temp = nullptr;
     }
 
     // Assignment operator; `operator=`
@@ -147,6 +296,7 @@ public:
             clear(); // Clear existing content
             root = cpy(other.root); // Deep copy
             sz = other.sz;
+            contentHash = other.contentHash;
         }
         return *this;
     }
@@ -154,9 +304,13 @@ public:
     // Empties the `prqueue`, freeing all memory it controls.
     // Runs in O(N)
     void clear() {
+        finishTraversal();
         remove(root);
         root = nullptr;
         sz = 0;
+        contentHash = 0;
+        curr = nullptr;
+        temp = nullptr;
     }
 
     // Destructor
@@ -167,8 +321,11 @@ public:
     }
 
     // Adds `value` to the `prqueue` with the given `priority`
-    // Runs in O(H + M)  H = height of the tree, and M = number of duplicate priorities
+    // Ends any unfinished begin()/next() traversal
+    // Runs in O(H + M)  H = height of the tree, and M = number of duplicate priorities,
+    // plus O(N) if a traversal was left unfinished
     void enqueue(T value, int priority) {
+        finishTraversal();
 
         //creates new node with value and priority
         NODE* newNode = new NODE; 
@@ -180,6 +337,7 @@ public:
         newNode->link = nullptr;
 
         sz++; //incs sz
+        contentHash += elementHash(value, priority);
 
         if (root == nullptr) { //tree is empty
             root = newNode;
@@ -232,11 +390,29 @@ public:
         return curr->value;
     }
 
+    // Returns the smallest priority in the `prqueue`
+    // Does not modify the `prqueue`
+    // If `prqueue` is empty, returns the default value for `int`
+    // Runs in O(H)     H = height of the tree
+    int peek_priority() const {
+        if (!root) {
+            return int{};
+        }
+        NODE* curr = root;
+        while (curr->left) {
+            curr = curr->left;
+        }
+        return curr->priority;
+    }
+
     // Returns value with the smallest priority in the `prqueue` 
     // Removes it from the `prqueue
     // If the `prqueue` is empty, returns the default value for `T`
-    // Runs in O(H + M)     H = height of the tree M = number of duplicate priorities
+    // Ends any unfinished begin()/next() traversal
+    // Runs in O(H + M)     H = height of the tree M = number of duplicate priorities,
+    // plus O(N) if a traversal was left unfinished
     T dequeue() {
+        finishTraversal();
         if (root == nullptr) {
             return T{};  // queue is empty return the default value of T
         }
@@ -327,6 +503,7 @@ public:
             linked->parent = parent;
         }
 
+        contentHash -= elementHash(returnValue, rmNode->priority);
         delete rmNode; //rm the node
         sz--; //dec size 
         return returnValue;
@@ -435,12 +612,144 @@ public:
     }
 
     // Checks if the contents of `this` and `other` are equivalent ie they have the same priorities,
-    // values, and same internal tree structure
-    // Runs in O(N) time, where N is the maximum number of nodes either `prqueue`
+    // values, same duplicate lists, and same internal tree structure
+    // Runs in O(1) when the sizes (or, if `Hashed`, the content hashes) differ,
+    // otherwise O(N) time, where N is the number of values in `this`
     bool operator==(const prqueue& other) const {
+        if (sz != other.sz || contentHash != other.contentHash) { //hashes are both 0 unless `Hashed`
+            return false;
+        }
         return equal(root, other.root);
     }
 
+    // Returns a hash of the priorities and values in the `prqueue`, independent of
+    // tree shape; equal queues always have equal hashes. Only with `Hashed` set
+    // Runs in O(1)
+    size_t content_hash() const requires Hashed {
+        return contentHash;
+    }
+
+    // Parallel `operator=` for very large queues: copies the top levels of
+    // `other` serially, then copies the subtrees below them on `threads`
+    // threads (0 = one per core), each thread allocating its own nodes
+    // Runs in O(N + O) work, about O((N + O) / P) time on P threads for balanced trees
+    void assign_parallel(const prqueue& other, unsigned threads = 0) {
+        if (this == &other) {
+            return;
+        }
+        clear_parallel(threads);
+
+        vector<COPYJOB> jobs;
+        cpyTop(other.root, nullptr, &root, splitDepth(threads), jobs);
+        vector<function<void()>> tasks;
+        for (const COPYJOB& job : jobs) {
+            tasks.push_back([this, job] { *job.dest = cpy(job.node, job.parent); });
+        }
+        runParallel(tasks, threads);
+        sz = other.sz;
+        contentHash = other.contentHash;
+    }
+
+    // Parallel `clear`: frees the subtrees below the top levels on `threads`
+    // threads (0 = one per core), then the top levels
+    // Runs in O(N) work, about O(N / P) time on P threads for balanced trees
+    void clear_parallel(unsigned threads = 0) {
+        finishTraversal();
+
+        vector<pair<NODE*, bool>> pieces;
+        split(root, splitDepth(threads), pieces);
+        vector<function<void()>> tasks;
+        for (const auto& piece : pieces) {
+            if (!piece.second) {
+                NODE* subtree = piece.first;
+                tasks.push_back([this, subtree] { remove(subtree); });
+            }
+        }
+        runParallel(tasks, threads);
+
+        for (const auto& piece : pieces) {
+            if (piece.second) { //a top node; its children are already freed or still in `pieces`
+                NODE* link = piece.first->link;
+                while (link != nullptr) {
+                    NODE* temp = link;
+                    link = link->link;
+                    delete temp;
+                }
+                delete piece.first;
+            }
+        }
+
+        root = nullptr;
+        sz = 0;
+        contentHash = 0;
+        curr = nullptr;
+        temp = nullptr;
+    }
+
+    // Parallel `operator==`: compares the top levels serially, then the
+    // subtree pairs below them on `threads` threads (0 = one per core),
+    // skipping remaining pairs once one differs
+    // Runs in O(N) work, about O(N / P) time on P threads for balanced trees
+    bool equal_parallel(const prqueue& other, unsigned threads = 0) const {
+        if (sz != other.sz || contentHash != other.contentHash) {
+            return false;
+        }
+        vector<pair<NODE*, NODE*>> jobs;
+        if (!equalTop(root, other.root, splitDepth(threads), jobs)) {
+            return false;
+        }
+
+        atomic<bool> same{true};
+        vector<function<void()>> tasks;
+        for (const auto& job : jobs) {
+            tasks.push_back([this, job, &same] {
+                if (same.load(memory_order_relaxed) && !equal(job.first, job.second)) {
+                    same.store(false, memory_order_relaxed);
+                }
+            });
+        }
+        runParallel(tasks, threads);
+        return same.load();
+    }
+
+    // Parallel `as_string`: formats the subtrees below the top levels into
+    // separate chunks on `threads` threads (0 = one per core), then
+    // concatenates the chunks in priority order
+    // Runs in O(N) work, about O(N / P) time on P threads for balanced trees
+    string as_string_parallel(unsigned threads = 0) const {
+        vector<pair<NODE*, bool>> pieces;
+        split(root, splitDepth(threads), pieces);
+
+        vector<string> chunks(pieces.size());
+        vector<function<void()>> tasks;
+        for (size_t i = 0; i < pieces.size(); i++) {
+            tasks.push_back([this, &pieces, &chunks, i] {
+                ostringstream oss;
+                if (pieces[i].second) { //a top node, just its duplicate list
+                    for (NODE* curr = pieces[i].first; curr != nullptr; curr = curr->link) {
+                        oss << curr->priority << " value: " << curr->value << endl;
+                    }
+                }
+                else {
+                    build_as_string(pieces[i].first, oss);
+                }
+                chunks[i] = oss.str();
+            });
+        }
+        runParallel(tasks, threads);
+
+        size_t length = 0;
+        for (const string& chunk : chunks) {
+            length += chunk.size();
+        }
+        string result;
+        result.reserve(length);
+        for (const string& chunk : chunks) {
+            result += chunk;
+        }
+        return result;
+    }
+
     // Returns a pointer to root node of the BST
     // Runs in O(1)
     void* getRoot() {
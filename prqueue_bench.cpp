@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "prqueue.h"
+#include "prqueue_compact.h"
+#include "prqueue_sharded.h"
+#include "prqueue_small.h"
+
+using namespace std;
+
+static const int PRIORITY_RANGE = 1 << 16;
+
+// Heap bytes currently allocated through operator new, including the
+// allocator's rounding where it can be measured
+static atomic<long long> heapBytes{0};
+static atomic<long long> heapAllocs{0};
+static atomic<long long> heapPeak{0};  // Highest heapBytes since the last reset_peak()
+
+static void reset_peak() {
+    heapPeak = heapBytes.load();
+}
+
+static size_t heap_size(void* p, size_t requested) {
+#ifdef __GLIBC__
+    return malloc_usable_size(p) + sizeof(size_t); //chunk header
+#else
+    return requested;
+#endif
+}
+
+void* operator new(size_t n) {
+    void* p = malloc(n ? n : 1);
+    if (!p) {
+        throw bad_alloc();
+    }
+    long long now = heapBytes += heap_size(p, n);
+    for (long long peak = heapPeak.load(); now > peak && !heapPeak.compare_exchange_weak(peak, now);) {
+    }
+    heapAllocs++;
+    return p;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // operator new above is malloc
+#endif
+
+void operator delete(void* p) noexcept {
+    if (p) {
+        heapBytes -= heap_size(p, 0);
+        free(p);
+    }
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+static double seconds_since(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static vector<unsigned> thread_counts() {
+    unsigned hw = thread::hardware_concurrency();
+    if (hw == 0) {
+        hw = 1;
+    }
+    vector<unsigned> counts;
+    for (unsigned t = 1; t < hw; t *= 2) {
+        counts.push_back(t);
+    }
+    counts.push_back(hw);
+    return counts;
+}
+
+// Each thread alternates enqueue and dequeue against one mutex-guarded prqueue
+static double global_mops(unsigned threads, int opsPerThread) {
+    prqueue<int> queue;
+    mutex lock;
+    for (int i = 0; i < 1024; i++) { //keep the queue non-empty
+        queue.enqueue(i, i * 61 % PRIORITY_RANGE);
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            mt19937 rng(t + 1);
+            for (int i = 0; i < opsPerThread; i++) {
+                lock_guard<mutex> guard(lock);
+                queue.enqueue(i, rng() % PRIORITY_RANGE);
+                queue.dequeue();
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    return 2.0 * threads * opsPerThread / seconds_since(start) / 1e6;
+}
+
+// Same workload against a sharded_prqueue with one shard per thread
+static double sharded_mops(unsigned threads, int opsPerThread) {
+    sharded_prqueue<int> queue(threads);
+    for (int i = 0; i < 1024; i++) {
+        queue.enqueue(i % threads, i, i * 61 % PRIORITY_RANGE);
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            mt19937 rng(t + 1);
+            int value;
+            int priority;
+            for (int i = 0; i < opsPerThread; i++) {
+                queue.enqueue(t, i, rng() % PRIORITY_RANGE);
+                queue.dequeue(t, value, priority);
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    return 2.0 * threads * opsPerThread / seconds_since(start) / 1e6;
+}
+
+// Drains a prefilled sharded queue concurrently and reports the rank error of
+// every dequeue: how many items still queued had a smaller priority.
+// A single global queue always has rank error 0.
+static void sharded_inversion(unsigned threads, int items) {
+    sharded_prqueue<int> queue(threads);
+    mt19937 rng(42);
+    for (int i = 0; i < items; i++) {
+        queue.enqueue(i % threads, i, rng() % PRIORITY_RANGE);
+    }
+
+    atomic<size_t> seq{0};
+    vector<int> order(items);
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            int value;
+            int priority;
+            while (queue.dequeue(t, value, priority)) {
+                order[seq.fetch_add(1)] = priority;
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    // Walk the dequeue log backwards, counting later (still queued) smaller priorities with a Fenwick tree
+    vector<int> fenwick(PRIORITY_RANGE + 1, 0);
+    double totalRank = 0;
+    size_t inverted = 0;
+    size_t worst = 0;
+    for (size_t i = seq.load(); i-- > 0;) {
+        size_t smaller = 0;
+        for (int p = order[i]; p > 0; p -= p & -p) {
+            smaller += fenwick[p];
+        }
+        for (int p = order[i] + 1; p <= PRIORITY_RANGE; p += p & -p) {
+            fenwick[p]++;
+        }
+        totalRank += smaller;
+        inverted += smaller != 0;
+        worst = max(worst, smaller);
+    }
+    size_t n = seq.load();
+    cout << "  threads " << threads << ": mean rank error " << totalRank / n << ", inverted dequeues "
+         << 100.0 * inverted / n << "%, worst rank error " << worst << endl;
+}
+
+static void bench_sharded() {
+    const int opsPerThread = 200000;
+    cout << "sharded_prqueue scaling (Mops/s, enqueue+dequeue pairs)" << endl;
+    for (unsigned threads : thread_counts()) {
+        cout << "  threads " << threads << ": global mutex " << global_mops(threads, opsPerThread) << ", sharded "
+             << sharded_mops(threads, opsPerThread) << endl;
+    }
+
+    cout << "sharded_prqueue priority inversion (concurrent drain of 200000 items)" << endl;
+    for (unsigned threads : thread_counts()) {
+        sharded_inversion(threads, 200000);
+    }
+}
+
+// Fills a queue with `items` random priorities and reports heap bytes per
+// element once filled and at the peak while filling, when old and new
+// buffers can both be live
+template <typename Q>
+static void compact_workload(const char* name, int items) {
+    mt19937 rng(7);
+    long long before = heapBytes.load();
+    reset_peak();
+    Q queue;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < items; i++) {
+        queue.enqueue(i, rng() % PRIORITY_RANGE);
+    }
+    double secs = seconds_since(start);
+    cout << "  " << name << ": " << double(heapBytes.load() - before) / items << " filled, "
+         << double(heapPeak.load() - before) / items << " peak (" << secs * 1e3 << " ms)" << endl;
+}
+
+static void bench_compact() {
+    cout << "memory per item (bytes, prqueue<int> vs compact_prqueue<int>)" << endl;
+    for (int items : { 1000, 100000, 1000000 }) {
+        cout << " items " << items << endl;
+        compact_workload<prqueue<int>>("prqueue", items);
+        compact_workload<compact_prqueue<int>>("compact_prqueue", items);
+    }
+}
+
+// Many tiny per-connection queues, each cycling a few enqueues and dequeues
+template <typename Q>
+static void small_workload(const char* name, int queues, int depth, int rounds) {
+    vector<Q> all(queues);
+    mt19937 rng(3);
+    long long before = heapAllocs.load();
+    auto start = chrono::steady_clock::now();
+    long long checksum = 0;
+    for (int r = 0; r < rounds; r++) {
+        for (Q& queue : all) {
+            for (int i = 0; i < depth; i++) {
+                queue.enqueue(i, rng() % PRIORITY_RANGE);
+            }
+            for (int i = 0; i < depth; i++) {
+                checksum += queue.dequeue();
+            }
+        }
+    }
+    double secs = seconds_since(start);
+    cout << "  " << name << ": " << 2.0 * queues * depth * rounds / secs / 1e6 << " Mops/s, "
+         << heapAllocs.load() - before << " allocations (checksum " << checksum << ")" << endl;
+}
+
+static void bench_small() {
+    for (int depth : { 4, 16, 32 }) {
+        cout << "tiny queues (10000 queues, depth " << depth << ")" << endl;
+        small_workload<prqueue<int>>("prqueue", 10000, depth, 20);
+        small_workload<small_prqueue<int>>("small_prqueue", 10000, depth, 20);
+    }
+}
+
+// Times the serial and parallel bulk operations on one large random queue
+static void bench_parallel() {
+    const int items = 2000000;
+    prqueue<int> queue;
+    mt19937 rng(11);
+    for (int i = 0; i < items; i++) {
+        queue.enqueue(i, rng() % (items / 4));
+    }
+    unsigned threads = thread::hardware_concurrency();
+    cout << "bulk operations on " << items << " items (ms, serial vs " << threads << " threads)" << endl;
+
+    prqueue<int> copy;
+    auto start = chrono::steady_clock::now();
+    copy = queue;
+    double serialCopy = seconds_since(start);
+    copy.clear(); //both copies start from an empty queue, so neither pays for a teardown
+    start = chrono::steady_clock::now();
+    copy.assign_parallel(queue);
+    double parallelCopy = seconds_since(start);
+    cout << "  copy: " << serialCopy * 1e3 << " vs " << parallelCopy * 1e3 << endl;
+
+    start = chrono::steady_clock::now();
+    bool same = copy == queue;
+    double serialEqual = seconds_since(start);
+    start = chrono::steady_clock::now();
+    same = same && copy.equal_parallel(queue);
+    double parallelEqual = seconds_since(start);
+    cout << "  equal: " << serialEqual * 1e3 << " vs " << parallelEqual * 1e3 << (same ? "" : " (MISMATCH)") << endl;
+
+    start = chrono::steady_clock::now();
+    size_t serialLength = queue.as_string().size();
+    double serialDump = seconds_since(start);
+    start = chrono::steady_clock::now();
+    size_t parallelLength = queue.as_string_parallel().size();
+    double parallelDump = seconds_since(start);
+    cout << "  as_string: " << serialDump * 1e3 << " vs " << parallelDump * 1e3
+         << (serialLength == parallelLength ? "" : " (MISMATCH)") << endl;
+
+    start = chrono::steady_clock::now();
+    queue.clear();
+    double serialClear = seconds_since(start);
+    start = chrono::steady_clock::now();
+    copy.clear_parallel();
+    double parallelClear = seconds_since(start);
+    cout << "  clear: " << serialClear * 1e3 << " vs " << parallelClear * 1e3 << endl;
+}
+
+int main(int argc, char** argv) {
+    const char* only = argc > 1 ? argv[1] : nullptr;
+    if (!only || strcmp(only, "sharded") == 0) {
+        bench_sharded();
+    }
+    if (!only || strcmp(only, "compact") == 0) {
+        bench_compact();
+    }
+    if (!only || strcmp(only, "small") == 0) {
+        bench_small();
+    }
+    if (!only || strcmp(only, "parallel") == 0) {
+        bench_parallel();
+    }
+    return 0;
+}
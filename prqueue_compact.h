@@ -0,0 +1,366 @@
+#pragma once
+
+#include <algorithm>  // For copying blocks
+#include <cstdint>    // For the 32-bit links
+#include <memory>     // For the node blocks
+#include <sstream>    // For as_string
+#include <stdexcept>  // For length_error
+#include <vector>     // For the node pool
+
+using namespace std;
+
+// Same queue as `prqueue`, stored compactly: nodes live in a pool and link
+// to each other by 32-bit index instead of by pointer, and there is no parent
+// link since the algorithms below track the parent while walking down.
+// Each element carries 12 bytes of links next to its priority and value
+// (20 bytes per element for `compact_prqueue<int>`). The pool grows in
+// fixed-size blocks rather than one allocation per element, and growing it
+// never copies nodes, so peak memory stays within one block of the steady state.
+template <typename T>
+class compact_prqueue {
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct NODE {
+        int priority;
+        uint32_t left;
+        uint32_t right;
+        uint32_t link;  // Next node with the same priority, or the next free slot
+        T value;
+    };
+
+    static constexpr int BLOCK_SHIFT = 10;
+    static constexpr uint32_t BLOCK_SIZE = 1u << BLOCK_SHIFT;  // Nodes per block
+    static constexpr uint32_t BLOCK_MASK = BLOCK_SIZE - 1;
+
+    vector<unique_ptr<NODE[]>> blocks;  // Node `i` is blocks[i >> BLOCK_SHIFT][i & BLOCK_MASK]
+    uint32_t used;      // Slots handed out so far; freed ones are on `freeList`
+    uint32_t root;
+    uint32_t freeList;  // Slots freed by dequeue, chained through `link`
+    size_t sz;
+
+    // Utility state for begin and next.
+    vector<uint32_t> stack;
+    uint32_t curr;
+
+    NODE& at(uint32_t index) {
+        return blocks[index >> BLOCK_SHIFT][index & BLOCK_MASK];
+    }
+
+    const NODE& at(uint32_t index) const {
+        return blocks[index >> BLOCK_SHIFT][index & BLOCK_MASK];
+    }
+
+    uint32_t allocate(T value, int priority) {
+        uint32_t index;
+        if (freeList != NIL) { //reuse a freed slot before growing the pool
+            index = freeList;
+            freeList = at(index).link;
+            at(index) = NODE{ priority, NIL, NIL, NIL, value };
+        }
+        else {
+            if (used == NIL) {
+                throw length_error("compact_prqueue: more than 2^32 - 1 elements");
+            }
+            if (used == blocks.size() * BLOCK_SIZE) {
+                blocks.emplace_back(new NODE[BLOCK_SIZE]);
+            }
+            index = used++;
+            at(index) = NODE{ priority, NIL, NIL, NIL, value };
+        }
+        return index;
+    }
+
+    void release(uint32_t index) {
+        at(index).value = T{};
+        at(index).link = freeList;
+        freeList = index;
+    }
+
+    // Pushes `index` and its left spine for the in-order traversal
+    void pushLeft(uint32_t index) {
+        while (index != NIL) {
+            stack.push_back(index);
+            index = at(index).left;
+        }
+    }
+
+    // Compares one node and its duplicate list, but not its children
+    bool equalNode(uint32_t og, const compact_prqueue& other, uint32_t copy) const {
+        while (og != NIL && copy != NIL) {
+            const NODE& a = at(og);
+            const NODE& b = other.at(copy);
+            if (a.priority != b.priority || a.value != b.value) {
+                return false;
+            }
+            og = a.link;
+            copy = b.link;
+        }
+        return og == copy; //both lists ended together
+    }
+
+    bool equal(uint32_t og, const compact_prqueue& other, uint32_t copy) const { //==operator helper, iterative so deep trees cannot overflow the stack
+        vector<pair<uint32_t, uint32_t>> pending;
+        pending.emplace_back(og, copy);
+        while (!pending.empty()) {
+            og = pending.back().first;
+            copy = pending.back().second;
+            pending.pop_back();
+
+            if (og == NIL && copy == NIL) {
+                continue;
+            }
+            if (og == NIL || copy == NIL) {
+                return false;
+            }
+            if (!equalNode(og, other, copy)) {
+                return false;
+            }
+            pending.emplace_back(at(og).left, other.at(copy).left);
+            pending.emplace_back(at(og).right, other.at(copy).right);
+        }
+        return true;
+    }
+
+public:
+    // Creates an empty `compact_prqueue`
+    // Runs in O(1)
+    compact_prqueue() {
+        used = 0;
+        root = NIL;
+        freeList = NIL;
+        sz = 0;
+        curr = NIL;
+    }
+
+    // Empties the `compact_prqueue`, freeing all memory it controls.
+    // Runs in O(N)
+    void clear() {
+        vector<unique_ptr<NODE[]>>().swap(blocks);
+        used = 0;
+        vector<uint32_t>().swap(stack);
+        root = NIL;
+        freeList = NIL;
+        sz = 0;
+        curr = NIL;
+    }
+
+    // Copy constructor
+    // Runs in O(N), where N is the number of slots used by `other`
+    compact_prqueue(const compact_prqueue& other) {
+        for (uint32_t start = 0; start < other.used; start += BLOCK_SIZE) {
+            blocks.emplace_back(new NODE[BLOCK_SIZE]);
+            uint32_t count = min(BLOCK_SIZE, other.used - start);
+            copy(other.blocks[start >> BLOCK_SHIFT].get(), other.blocks[start >> BLOCK_SHIFT].get() + count, blocks.back().get());
+        }
+        used = other.used;
+        root = other.root;
+        freeList = other.freeList;
+        sz = other.sz;
+        curr = NIL;
+    }
+
+    // Assignment operator; `operator=`
+    // Runs in O(N + O)  N = number of values in `this` and O = number of slots used by `other`
+    compact_prqueue& operator=(const compact_prqueue& other) {
+        if (this != &other) {
+            compact_prqueue copy(other);
+            blocks.swap(copy.blocks);
+            used = copy.used;
+            root = copy.root;
+            freeList = copy.freeList;
+            sz = copy.sz;
+            stack.clear();
+            curr = NIL;
+        }
+        return *this;
+    }
+
+    // Reserves pool space for `n` elements so enqueue does not allocate
+    // Runs in O(N)
+    void reserve(size_t n) {
+        while (blocks.size() * BLOCK_SIZE < n) {
+            blocks.emplace_back(new NODE[BLOCK_SIZE]);
+        }
+    }
+
+    // Adds `value` to the `compact_prqueue` with the given `priority`
+    // Runs in O(H + M)  H = height of the tree, and M = number of duplicate priorities
+    void enqueue(T value, int priority) {
+        uint32_t newNode = allocate(value, priority);
+        sz++;
+
+        if (root == NIL) {
+            root = newNode;
+            return;
+        }
+
+        uint32_t curr = root;
+        while (true) { //finds place that the new node goes
+            NODE& node = at(curr);
+            if (priority > node.priority) {
+                if (node.right == NIL) {
+                    node.right = newNode;
+                    return;
+                }
+                curr = node.right;
+            }
+            else if (priority < node.priority) {
+                if (node.left == NIL) {
+                    node.left = newNode;
+                    return;
+                }
+                curr = node.left;
+            }
+            else {
+                while (at(curr).link != NIL) { //append to the end of the duplicate list
+                    curr = at(curr).link;
+                }
+                at(curr).link = newNode;
+                return;
+            }
+        }
+    }
+
+    // Returns value with the smallest priority in the `compact_prqueue`
+    // Does not modify the `compact_prqueue`
+    // If `compact_prqueue` is empty, returns the default value for `T`
+    // Runs in O(H)     H = height of the tree
+    T peek() const {
+        if (root == NIL) {
+            return T{};
+        }
+        uint32_t curr = root;
+        while (at(curr).left != NIL) {
+            curr = at(curr).left;
+        }
+        return at(curr).value;
+    }
+
+    // Returns the smallest priority in the `compact_prqueue`
+    // If `compact_prqueue` is empty, returns the default value for `int`
+    // Runs in O(H)     H = height of the tree
+    int peek_priority() const {
+        if (root == NIL) {
+            return int{};
+        }
+        uint32_t curr = root;
+        while (at(curr).left != NIL) {
+            curr = at(curr).left;
+        }
+        return at(curr).priority;
+    }
+
+    // Returns value with the smallest priority in the `compact_prqueue`
+    // Removes it from the `compact_prqueue`
+    // If the `compact_prqueue` is empty, returns the default value for `T`
+    // Runs in O(H)     H = height of the tree
+    T dequeue() {
+        if (root == NIL) {
+            return T{};
+        }
+
+        // The leftmost node has no left child, so it is replaced either by
+        // the next duplicate in its list or by its right subtree.
+        uint32_t parent = NIL;
+        uint32_t rmNode = root;
+        while (at(rmNode).left != NIL) {
+            parent = rmNode;
+            rmNode = at(rmNode).left;
+        }
+
+        uint32_t replace = at(rmNode).right;
+        if (at(rmNode).link != NIL) { //dupes
+            replace = at(rmNode).link;
+            at(replace).right = at(rmNode).right;
+        }
+
+        if (parent == NIL) {
+            root = replace;
+        }
+        else {
+            at(parent).left = replace;
+        }
+
+        T returnValue = at(rmNode).value;
+        release(rmNode);
+        sz--;
+        if (sz == 0) { //drop freed slots once the queue drains, keeping the blocks
+            used = 0;
+            freeList = NIL;
+        }
+        return returnValue;
+    }
+
+    // Returns the number of elements in the `compact_prqueue`
+    // Runs in O(1)
+    size_t size() const {
+        return sz;
+    }
+
+    // Returns the bytes held by the node pool, including unused slots in the last block
+    // Runs in O(1)
+    size_t memory_bytes() const {
+        return blocks.size() * BLOCK_SIZE * sizeof(NODE) + blocks.capacity() * sizeof(blocks[0]);
+    }
+
+    // Resets internal state for an in-order traversal
+    // Does not modify the tree, unlike `prqueue::begin`
+    // O(H)     H = maximum height of the tree
+    void begin() {
+        stack.clear();
+        curr = NIL;
+        pushLeft(root);
+    }
+
+    // Uses internal state to return next in-order value and priority
+    // by reference and advances the internal state
+    // Returns true if reference parameters were set, and false otherwise
+    // Runs in amortized O(1)
+    bool next(T& value, int& priority) {
+        if (curr == NIL) { //done with the current duplicate list, take the next tree node
+            if (stack.empty()) {
+                return false;
+            }
+            curr = stack.back();
+            stack.pop_back();
+            pushLeft(at(curr).right);
+        }
+
+        value = at(curr).value;
+        priority = at(curr).priority;
+        curr = at(curr).link;
+        return true;
+    }
+
+    // Converts the `compact_prqueue` to a string representation in priority order
+    // Runs in O(N)
+    string as_string() const {
+        ostringstream oss;
+        vector<uint32_t> path;
+        uint32_t node = root;
+        while (node != NIL || !path.empty()) {
+            while (node != NIL) {
+                path.push_back(node);
+                node = at(node).left;
+            }
+            node = path.back();
+            path.pop_back();
+            for (uint32_t dup = node; dup != NIL; dup = at(dup).link) {
+                oss << at(dup).priority << " value: " << at(dup).value << endl;
+            }
+            node = at(node).right;
+        }
+        return oss.str();
+    }
+
+    // Checks if the contents of `this` and `other` are equivalent ie they have the same priorities,
+    // values, same duplicate lists, and same internal tree structure
+    // Runs in O(1) when the sizes differ, otherwise O(N) time, where N is the number of values in `this`
+    bool operator==(const compact_prqueue& other) const {
+        if (sz != other.sz) {
+            return false;
+        }
+        return equal(root, other, other.root);
+    }
+};
@@ -0,0 +1,469 @@
+#pragma once
+
+#include <algorithm>    // For choosing runs to merge
+#include <atomic>       // For unique run directory names
+#include <climits>      // For INT_MAX
+#include <chrono>       // For unique run directory names
+#include <cstdint>      // For sequence numbers
+#include <cstdio>       // For snprintf
+#include <cstring>      // For zeroing record padding
+#include <filesystem>   // For the run directory
+#include <fstream>      // For run files
+#include <memory>       // For the open runs
+#include <random>       // For unique run directory names
+#include <stdexcept>    // For runtime_error
+#include <string>
+#include <type_traits>  // For is_trivially_copyable
+#include <vector>
+
+#include "prqueue.h"
+
+using namespace std;
+
+// Priority queue that can hold more elements than fit in memory. At most
+// `memoryItems` elements live in an in-memory `prqueue`; when it fills up,
+// its larger half is written to a sorted run file in a subdirectory of
+// `directory` that belongs to this queue alone. Dequeue
+// takes the smaller of the in-memory minimum and the minimum across the run
+// files, which are read back sequentially through small buffers. Elements
+// with equal priorities still come out in the order they were enqueued.
+// `T` is written to disk as raw bytes, so it must be trivially copyable.
+template <typename T>
+class external_prqueue {
+    static_assert(is_trivially_copyable<T>::value, "external_prqueue: T must be trivially copyable");
+
+private:
+    // An element as stored in memory; `seq` orders equal priorities across memory and disk
+    struct ENTRY {
+        uint64_t seq;
+        T value;
+    };
+
+    // An element as stored in a run file; `seq` comes first so `priority` and a
+    // small `T` share its alignment, 16 bytes for `T = int`
+    struct RECORD {
+        uint64_t seq;
+        int priority;
+        T value;
+    };
+
+    // A sorted run file being read back through `buffer`
+    struct RUN {
+        filesystem::path path;
+        ifstream in;
+        vector<RECORD> buffer;
+        size_t pos = 0;
+        uint64_t start = 0;   // Index in the file of `buffer[0]`
+        uint64_t unread = 0;  // Records still in the file past `buffer`
+
+        // Records not yet dequeued from this run
+        uint64_t remaining() const {
+            return buffer.size() - pos + unread;
+        }
+    };
+
+    filesystem::path directory;  // Private to this queue, created inside the caller's directory
+    size_t memoryItems;
+    size_t bufferItems;
+    size_t maxRuns;
+
+    prqueue<ENTRY> mem;
+    vector<unique_ptr<RUN>> runs;
+    uint64_t nextSeq;
+    uint64_t runNumber;
+    uint64_t written;  // Records written to run files so far, including merges
+    size_t sz;
+
+    static bool less(int priority, uint64_t seq, const RECORD& other) {
+        return priority < other.priority || (priority == other.priority && seq < other.seq);
+    }
+
+    filesystem::path runPath() {
+        return directory / ("run_" + to_string(runNumber++) + ".run");
+    }
+
+    // Builds a record with any padding zeroed, since records are written as raw bytes
+    static RECORD makeRecord(int priority, uint64_t seq, const T& value) {
+        RECORD record;
+        memset((void*)&record, 0, sizeof(RECORD));
+        record.seq = seq;
+        record.priority = priority;
+        record.value = value;
+        return record;
+    }
+
+    static void writeRecords(ofstream& out, const vector<RECORD>& records, const filesystem::path& path) {
+        out.write((const char*)records.data(), records.size() * sizeof(RECORD));
+        if (!out) {
+            throw runtime_error("external_prqueue: cannot write " + path.string());
+        }
+    }
+
+    // Reads the next buffer of records; returns false once the run is exhausted
+    bool refill(RUN& run) {
+        run.start += run.buffer.size();
+        run.buffer.clear();
+        run.pos = 0;
+        if (run.unread == 0) {
+            return false;
+        }
+        size_t n = run.unread < bufferItems ? run.unread : bufferItems;
+        run.buffer.resize(n);
+        run.in.read((char*)run.buffer.data(), n * sizeof(RECORD));
+        if (!run.in) {
+            throw runtime_error("external_prqueue: cannot read " + run.path.string());
+        }
+        run.unread -= n;
+        return true;
+    }
+
+    // Opens a reader over records [offset, count) of a run file
+    unique_ptr<RUN> openReader(const filesystem::path& path, uint64_t count, uint64_t offset) {
+        unique_ptr<RUN> run(new RUN);
+        run->path = path;
+        run->in.open(path, ios::binary);
+        if (!run->in || !run->in.seekg(offset * sizeof(RECORD))) {
+            throw runtime_error("external_prqueue: cannot open " + path.string());
+        }
+        run->start = offset;
+        run->unread = count - offset;
+        refill(*run);
+        return run;
+    }
+
+    // Opens a run file written with `count` records
+    void openRun(const filesystem::path& path, uint64_t count) {
+        if (count == 0) {
+            filesystem::remove(path);
+            return;
+        }
+        runs.push_back(openReader(path, count, 0));
+    }
+
+    void closeRun(size_t index) {
+        runs[index]->in.close();
+        error_code ignored; //also called from the destructor, which must not throw
+        filesystem::remove(runs[index]->path, ignored);
+        runs.erase(runs.begin() + index);
+    }
+
+    // Returns the index of the reader in `list` holding the smallest head, or list.size() if there are none
+    // Runs in O(R)     R = number of readers
+    static size_t minHead(const vector<unique_ptr<RUN>>& list) {
+        size_t best = list.size();
+        for (size_t i = 0; i < list.size(); i++) {
+            const RECORD& head = list[i]->buffer[list[i]->pos];
+            if (best == list.size() || less(head.priority, head.seq, list[best]->buffer[list[best]->pos])) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // Returns the index of the run holding the smallest head, or runs.size() if there are none
+    // Runs in O(R)     R = number of runs
+    size_t minRun() const {
+        return minHead(runs);
+    }
+
+    // Moves past the head of run `index`, closing the run when it is exhausted
+    void advance(size_t index) {
+        RUN& run = *runs[index];
+        if (++run.pos == run.buffer.size() && !refill(run)) {
+            closeRun(index);
+        }
+    }
+
+    // Re-enqueues sorted `records` into `mem` median-first, one priority group at a time,
+    // so the rebuilt tree is balanced and duplicates keep their order
+    void rebuild(const vector<RECORD>& records, const vector<size_t>& groups, size_t lo, size_t hi) {
+        if (lo >= hi) {
+            return;
+        }
+        size_t mid = lo + (hi - lo) / 2;
+        for (size_t i = groups[mid]; i < groups[mid + 1]; i++) {
+            mem.enqueue(ENTRY{ records[i].seq, records[i].value }, records[i].priority);
+        }
+        rebuild(records, groups, lo, mid);
+        rebuild(records, groups, mid + 1, hi);
+    }
+
+    // Re-enqueues `records[0, count)` into `mem`
+    void restore(const vector<RECORD>& records, size_t count) {
+        vector<size_t> groups;
+        for (size_t i = 0; i < count; i++) {
+            if (i == 0 || records[i].priority != records[i - 1].priority) {
+                groups.push_back(i);
+            }
+        }
+        size_t groupCount = groups.size();
+        groups.push_back(count);
+        rebuild(records, groups, 0, groupCount);
+    }
+
+    // Writes the larger half of `mem` to a new sorted run and keeps the smaller half in memory
+    // If the run cannot be written, every element goes back into `mem` before the error is rethrown
+    void spill() {
+        vector<RECORD> records;
+        records.reserve(mem.size());
+        while (mem.size() > 0) { //dequeue order is already sorted
+            int priority = mem.peek_priority();
+            ENTRY entry = mem.dequeue();
+            records.push_back(makeRecord(priority, entry.seq, entry.value));
+        }
+
+        size_t keep = records.size() / 2;
+
+        filesystem::path path = runPath();
+        try {
+            {
+                ofstream out(path, ios::binary | ios::trunc);
+                if (!out) {
+                    throw runtime_error("external_prqueue: cannot create " + path.string());
+                }
+                vector<RECORD> upper(records.begin() + keep, records.end());
+                writeRecords(out, upper, path);
+                out.close();
+                if (!out) {
+                    throw runtime_error("external_prqueue: cannot write " + path.string());
+                }
+            }
+            openRun(path, records.size() - keep);
+            written += records.size() - keep;
+        }
+        catch (...) {
+            error_code ignored;
+            filesystem::remove(path, ignored);
+            restore(records, records.size());
+            throw;
+        }
+
+        restore(records, keep);
+
+        if (runs.size() > maxRuns) {
+            mergeRuns();
+        }
+    }
+
+    // Size class of a run: runs in the same class are within a factor of two of each other
+    static int level(const RUN& run) {
+        int level = 0;
+        for (uint64_t n = run.remaining(); n > 1; n >>= 1) {
+            level++;
+        }
+        return level;
+    }
+
+    // Merges runs of similar size into one so the number of open files and
+    // buffers stays bounded. Merging every run in the smallest size class that
+    // has more than one at least doubles the size of each merged record's run,
+    // so each record is rewritten O(log(N / K)) times. Only when every run is in
+    // a different size class are the two smallest merged.
+    // The merged run is read through separate readers and the old runs are only
+    // closed once it is written, so a failed merge loses nothing.
+    void mergeRuns() {
+        vector<size_t> selected;
+        int mergeLevel = INT_MAX;
+        for (size_t i = 0; i < runs.size(); i++) {
+            int candidate = level(*runs[i]);
+            if (candidate >= mergeLevel) {
+                continue;
+            }
+            for (size_t j = i + 1; j < runs.size(); j++) {
+                if (level(*runs[j]) == candidate) {
+                    mergeLevel = candidate;
+                    break;
+                }
+            }
+        }
+        for (size_t i = 0; i < runs.size(); i++) {
+            if (level(*runs[i]) == mergeLevel) {
+                selected.push_back(i);
+            }
+        }
+        if (selected.empty()) {
+            for (size_t i = 0; i < runs.size(); i++) {
+                selected.push_back(i);
+            }
+            sort(selected.begin(), selected.end(), [this](size_t a, size_t b) {
+                return runs[a]->remaining() < runs[b]->remaining();
+            });
+            selected.resize(2);
+        }
+
+        filesystem::path path = runPath();
+        unique_ptr<RUN> merged;
+        uint64_t total = 0;
+        try {
+            vector<unique_ptr<RUN>> readers;
+            for (size_t index : selected) {
+                RUN& run = *runs[index];
+                readers.push_back(openReader(run.path, run.start + run.buffer.size() + run.unread, run.start + run.pos));
+            }
+
+            ofstream out(path, ios::binary | ios::trunc);
+            if (!out) {
+                throw runtime_error("external_prqueue: cannot create " + path.string());
+            }
+            vector<RECORD> pending;
+            pending.reserve(bufferItems);
+            while (!readers.empty()) {
+                size_t index = minHead(readers);
+                RUN& reader = *readers[index];
+                pending.push_back(reader.buffer[reader.pos]);
+                if (++reader.pos == reader.buffer.size() && !refill(reader)) {
+                    readers.erase(readers.begin() + index);
+                }
+                if (pending.size() == bufferItems) {
+                    writeRecords(out, pending, path);
+                    total += pending.size();
+                    pending.clear();
+                }
+            }
+            writeRecords(out, pending, path);
+            total += pending.size();
+            out.close();
+            if (!out) {
+                throw runtime_error("external_prqueue: cannot write " + path.string());
+            }
+            merged = openReader(path, total, 0);
+        }
+        catch (...) {
+            error_code ignored;
+            filesystem::remove(path, ignored);
+            throw;
+        }
+
+        sort(selected.begin(), selected.end());
+        for (size_t i = selected.size(); i-- > 0;) { //highest index first so the others stay valid
+            closeRun(selected[i]);
+        }
+        runs.push_back(move(merged));
+        written += total;
+    }
+
+public:
+    // Creates an empty `external_prqueue` that spills into `directory`
+    // `memoryItems` bounds the elements kept in memory, `bufferItems` is the
+    // read and write buffer per run, and `maxRuns` bounds the open run files
+    // Runs in O(1)
+    external_prqueue(const string& directory, size_t memoryItems, size_t bufferItems = 4096, size_t maxRuns = 16)
+        : memoryItems(memoryItems < 2 ? 2 : memoryItems),
+          bufferItems(bufferItems == 0 ? 1 : bufferItems),
+          maxRuns(maxRuns < 2 ? 2 : maxRuns) {
+        // Runs go in a fresh subdirectory so queues in other processes, or a
+        // restarted process, sharing `directory` never open each other's runs.
+        // create_directory fails on an existing name, so a clash just retries.
+        static atomic<size_t> instances{0};
+        filesystem::create_directories(directory);
+        random_device seed;
+        mt19937_64 rng(((uint64_t)seed() << 32) ^ seed() ^ (uint64_t)chrono::steady_clock::now().time_since_epoch().count());
+        size_t instance = instances++;
+        do {
+            char token[17];
+            snprintf(token, sizeof(token), "%016llx", (unsigned long long)rng());
+            this->directory = filesystem::path(directory) / ("prqueue_" + string(token) + "_" + to_string(instance));
+        } while (!filesystem::create_directory(this->directory));
+
+        nextSeq = 0;
+        runNumber = 0;
+        written = 0;
+        sz = 0;
+    }
+
+    external_prqueue(const external_prqueue&) = delete;
+    external_prqueue& operator=(const external_prqueue&) = delete;
+
+    // Empties the `external_prqueue`, deleting its run files
+    // Runs in O(N)
+    void clear() {
+        mem.clear();
+        while (!runs.empty()) {
+            closeRun(runs.size() - 1);
+        }
+        sz = 0;
+    }
+
+    // Destructor
+    // Runs in O(N)
+    ~external_prqueue() {
+        clear();
+        error_code ignored;
+        filesystem::remove(directory, ignored);
+    }
+
+    // Adds `value` to the `external_prqueue` with the given `priority`
+    // Runs in O(H + M), plus O(K) for the enqueue that spills    K = memoryItems
+    void enqueue(T value, int priority) {
+        if (mem.size() >= memoryItems) {
+            spill();
+        }
+        mem.enqueue(ENTRY{ nextSeq++, value }, priority);
+        sz++;
+    }
+
+    // Returns value with the smallest priority in the `external_prqueue`
+    // Removes it from the `external_prqueue`
+    // If the `external_prqueue` is empty, returns the default value for `T`
+    // Runs in O(H + M + R)     R = number of runs
+    T dequeue() {
+        if (sz == 0) {
+            return T{};
+        }
+
+        size_t index = minRun();
+        if (index != runs.size()) {
+            const RECORD& head = runs[index]->buffer[runs[index]->pos];
+            if (mem.size() == 0 || !less(mem.peek_priority(), mem.peek().seq, head)) {
+                T returnValue = head.value;
+                advance(index);
+                sz--;
+                return returnValue;
+            }
+        }
+
+        sz--;
+        return mem.dequeue().value;
+    }
+
+    // Returns value with the smallest priority in the `external_prqueue`
+    // If `external_prqueue` is empty, returns the default value for `T`
+    // Runs in O(H + M + R)     R = number of runs
+    T peek() const {
+        if (sz == 0) {
+            return T{};
+        }
+        size_t index = minRun();
+        if (index != runs.size()) {
+            const RECORD& head = runs[index]->buffer[runs[index]->pos];
+            if (mem.size() == 0 || !less(mem.peek_priority(), mem.peek().seq, head)) {
+                return head.value;
+            }
+        }
+        return mem.peek().value;
+    }
+
+    // Returns the number of elements in the `external_prqueue`
+    // Runs in O(1)
+    size_t size() const {
+        return sz;
+    }
+
+    // Returns the number of elements currently held in memory
+    // Runs in O(1)
+    size_t memory_size() const {
+        return mem.size();
+    }
+
+    // Returns the number of records written to run files so far, including rewrites by merges
+    // Runs in O(1)
+    uint64_t records_written() const {
+        return written;
+    }
+
+    // Returns the number of run files currently on disk
+    // Runs in O(1)
+    size_t run_count() const {
+        return runs.size();
+    }
+};
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>  // For the traversal frontier
+#include <cstdint>    // For sequence numbers
+#include <memory>     // For the shared nodes
+#include <sstream>    // For as_string
+#include <vector>     // For the traversal frontier
+
+using namespace std;
+
+// Persistent version of `prqueue`: nodes are immutable and reference counted,
+// and a copy shares every node with the original, so copying is O(1) and a
+// copy never sees later changes to the original. Once taken, a copy can be
+// read, iterated and destroyed from another thread while the original keeps
+// changing; taking the copy reads the original, so it needs whatever
+// synchronization other reads of it use.
+//
+// The nodes form a leftist heap rather than a search tree: every node's
+// right spine has O(log N) nodes, and enqueue and dequeue only rebuild nodes
+// on right spines, so each copies O(log N) nodes whatever order the
+// priorities arrive in. Equal priorities are ordered by a sequence number,
+// so they dequeue oldest first like `prqueue`.
+template <typename T>
+class persistent_prqueue {
+private:
+    struct NODE;
+    using LINK = shared_ptr<NODE>;
+
+    // Never modified once another queue can reach it
+    struct NODE {
+        int priority;
+        uint64_t seq;
+        T value;
+        uint32_t rank;  // Length of the right spine, never more than the left child's
+        LINK left;
+        LINK right;
+
+        NODE(int priority, uint64_t seq, const T& value, uint32_t rank, LINK left, LINK right)
+            : priority(priority), seq(seq), value(value), rank(rank), left(move(left)), right(move(right)) {
+        }
+
+        ~NODE() {
+            releaseChildren(left, right);
+        }
+    };
+
+    LINK root;
+    size_t sz;
+    uint64_t nextSeq;
+
+    // Utility state for begin and next: a min-heap of nodes not yet returned
+    // whose parents have been.
+    vector<const NODE*> frontier;
+
+    static bool less(const NODE* a, const NODE* b) {
+        return a->priority < b->priority || (a->priority == b->priority && a->seq < b->seq);
+    }
+
+    static bool greater(const NODE* a, const NODE* b) {
+        return less(b, a);
+    }
+
+    static uint32_t rank(const LINK& node) {
+        return node ? node->rank : 0;
+    }
+
+    // Merges two heaps, copying only the nodes on the right spines it walks
+    // Runs in O(log N + log M)
+    static LINK merge(const LINK& a, const LINK& b) {
+        if (!a) {
+            return b;
+        }
+        if (!b) {
+            return a;
+        }
+        if (less(b.get(), a.get())) {
+            return merge(b, a);
+        }
+
+        LINK right = merge(a->right, b);
+        if (rank(a->left) < rank(right)) { //keep the shorter spine on the right
+            return make_shared<NODE>(a->priority, a->seq, a->value, a->left ? a->left->rank + 1 : 1, right, a->left);
+        }
+        return make_shared<NODE>(a->priority, a->seq, a->value, right->rank + 1, a->left, right);
+    }
+
+    // Called as a node dies, on whichever thread dropped the last reference to it.
+    // The outermost call on a thread keeps a list of dying children on its own
+    // stack and frees them in a loop; nested calls, made by the nodes it frees,
+    // only add to that list. So a long path of nodes never recurses deeply.
+    // The thread-local is a plain pointer rather than the list itself so that
+    // nothing is destroyed at thread exit, and queues with static storage
+    // duration can still free their nodes after thread-locals are gone.
+    static void releaseChildren(LINK& left, LINK& right) {
+        thread_local vector<LINK>* pending = nullptr;
+        if (pending != nullptr) {
+            if (left) {
+                pending->push_back(move(left));
+            }
+            if (right) {
+                pending->push_back(move(right));
+            }
+            return;
+        }
+
+        vector<LINK> local;
+        if (left) {
+            local.push_back(move(left));
+        }
+        if (right) {
+            local.push_back(move(right));
+        }
+        pending = &local;
+        while (!local.empty()) {
+            LINK curr = move(local.back());
+            local.pop_back();
+            curr.reset(); //if this was the last reference, its children join `local`
+        }
+        pending = nullptr;
+    }
+
+    void pushFrontier(const NODE* node) {
+        if (node != nullptr) {
+            frontier.push_back(node);
+            push_heap(frontier.begin(), frontier.end(), greater);
+        }
+    }
+
+public:
+    // Creates an empty `persistent_prqueue`
+    // Runs in O(1)
+    persistent_prqueue() {
+        sz = 0;
+        nextSeq = 0;
+    }
+
+    // Copy constructor, shares every node with `other`
+    // Runs in O(1)
+    persistent_prqueue(const persistent_prqueue& other) {
+        root = other.root;
+        sz = other.sz;
+        nextSeq = other.nextSeq;
+    }
+
+    // Assignment operator; `operator=`
+    // Runs in O(1), plus O(N) to free nodes no longer shared with any other queue
+    persistent_prqueue& operator=(const persistent_prqueue& other) {
+        if (this != &other) {
+            root = other.root;
+            sz = other.sz;
+            nextSeq = other.nextSeq;
+            frontier.clear();
+        }
+        return *this;
+    }
+
+    // Empties the `persistent_prqueue`
+    // Runs in O(1), plus O(N) to free nodes not shared with any other queue
+    void clear() {
+        frontier.clear();
+        root = nullptr;
+        sz = 0;
+    }
+
+    // Destructor
+    // Runs in O(1), plus O(N) to free nodes not shared with any other queue
+    ~persistent_prqueue() {
+        clear();
+    }
+
+    // Returns an immutable copy of the current contents
+    // Runs in O(1)
+    persistent_prqueue snapshot() const {
+        return *this;
+    }
+
+    // Adds `value` to the `persistent_prqueue` with the given `priority`
+    // Copies the nodes on one right spine, leaving every copy unchanged
+    // Runs in O(log N)
+    void enqueue(T value, int priority) {
+        LINK single = make_shared<NODE>(priority, nextSeq++, value, 1, nullptr, nullptr);
+
+        frontier.clear();
+        root = merge(root, single);
+        sz++;
+    }
+
+    // Returns value with the smallest priority in the `persistent_prqueue`
+    // If `persistent_prqueue` is empty, returns the default value for `T`
+    // Runs in O(1)
+    T peek() const {
+        if (!root) {
+            return T{};
+        }
+        return root->value;
+    }
+
+    // Returns the smallest priority in the `persistent_prqueue`
+    // If `persistent_prqueue` is empty, returns the default value for `int`
+    // Runs in O(1)
+    int peek_priority() const {
+        if (!root) {
+            return int{};
+        }
+        return root->priority;
+    }
+
+    // Returns value with the smallest priority in the `persistent_prqueue`
+    // Removes it from this `persistent_prqueue`, leaving every copy unchanged
+    // If the `persistent_prqueue` is empty, returns the default value for `T`
+    // Runs in O(log N)
+    T dequeue() {
+        if (!root) {
+            return T{};
+        }
+
+        T returnValue = root->value;
+
+        frontier.clear();
+        root = merge(root->left, root->right);
+        sz--;
+        return returnValue;
+    }
+
+    // Returns the number of elements in the `persistent_prqueue`
+    // Runs in O(1)
+    size_t size() const {
+        return sz;
+    }
+
+    // Resets internal state for a traversal in priority order
+    // Does not modify the heap, so copies can be traversed from other threads
+    // Runs in O(1)
+    void begin() {
+        frontier.clear();
+        pushFrontier(root.get());
+    }
+
+    // Uses internal state to return next value and priority in priority order
+    // by reference and advances the internal state
+    // Returns true if reference parameters were set, and false otherwise
+    // Runs in O(log K)     K = number of values returned so far
+    bool next(T& value, int& priority) {
+        if (frontier.empty()) {
+            return false;
+        }
+        pop_heap(frontier.begin(), frontier.end(), greater);
+        const NODE* curr = frontier.back();
+        frontier.pop_back();
+        pushFrontier(curr->left.get());
+        pushFrontier(curr->right.get());
+
+        value = curr->value;
+        priority = curr->priority;
+        return true;
+    }
+
+    // Converts the `persistent_prqueue` to a string representation in priority order
+    // Runs in O(N log N)
+    string as_string() const {
+        ostringstream oss;
+        vector<const NODE*> pending;
+        if (root) {
+            pending.push_back(root.get());
+        }
+        while (!pending.empty()) {
+            pop_heap(pending.begin(), pending.end(), greater);
+            const NODE* node = pending.back();
+            pending.pop_back();
+            oss << node->priority << " value: " << node->value << endl;
+            for (const NODE* child : { node->left.get(), node->right.get() }) {
+                if (child != nullptr) {
+                    pending.push_back(child);
+                    push_heap(pending.begin(), pending.end(), greater);
+                }
+            }
+        }
+        return oss.str();
+    }
+
+    // Checks if the contents of `this` and `other` are equivalent ie they have the same priorities,
+    // values, and same internal heap structure
+    // Subtrees shared between the two queues are equal without being walked
+    // Runs in O(N) time, where N is the number of nodes not shared between the queues
+    bool operator==(const persistent_prqueue& other) const {
+        if (sz != other.sz) {
+            return false;
+        }
+        vector<pair<const NODE*, const NODE*>> pending;
+        pending.emplace_back(root.get(), other.root.get());
+        while (!pending.empty()) {
+            const NODE* og = pending.back().first;
+            const NODE* copy = pending.back().second;
+            pending.pop_back();
+            if (og == copy) { //same node, or both empty
+                continue;
+            }
+            if (og == nullptr || copy == nullptr) {
+                return false;
+            }
+            if (og->priority != copy->priority || og->value != copy->value) {
+                return false;
+            }
+            pending.emplace_back(og->left.get(), copy->left.get());
+            pending.emplace_back(og->right.get(), copy->right.get());
+        }
+        return true;
+    }
+};
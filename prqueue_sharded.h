@@ -0,0 +1,230 @@
+#pragma once
+
+#include <atomic>   // For the per-shard minimum and size
+#include <climits>  // For INT_MAX
+#include <cstdint>  // For the sampling rng state
+#include <memory>   // For the shard array
+#include <mutex>    // For the per-shard lock
+#include <vector>   // For the stolen batch
+
+#include "prqueue.h"
+
+using namespace std;
+
+// Front-end that keeps one `prqueue` per worker instead of one global queue.
+// Each worker enqueues and dequeues on its own shard; ordering is only strict
+// within a shard. A worker steals a batch of its peer's smallest items when
+// its own shard is empty or when its minimum is much worse than a sampled
+// peer's minimum.
+template <typename T>
+class sharded_prqueue {
+private:
+    // One shard per worker, each on its own cache line so that local
+    // operations never share a line with another worker's shard.
+    struct alignas(64) SHARD {
+        mutex lock;
+        prqueue<T> queue;
+        atomic<int> minPriority{INT_MAX}; // INT_MAX when empty, read by peers without the lock
+        atomic<size_t> count{0};
+        uint64_t rng = 0;                 // Only touched by the owning worker
+        size_t sinceSample = 0;           // Only touched by the owning worker
+    };
+
+    unique_ptr<SHARD[]> shards;
+    size_t numShards;
+
+    size_t stealBatch;
+    int stealThreshold;
+    size_t sampleInterval;
+
+    // A stolen batch is briefly in neither shard, so a dequeue that finds every
+    // shard empty only reports an empty queue if no steal overlapped its check
+    atomic<size_t> stealsStarted{0};
+    atomic<size_t> stealsDone{0};
+
+    // Refreshes the values peers read; caller must hold `shard.lock`
+    void publish(SHARD& shard) {
+        shard.count.store(shard.queue.size(), memory_order_relaxed);
+        shard.minPriority.store(shard.queue.size() ? shard.queue.peek_priority() : INT_MAX, memory_order_relaxed);
+    }
+
+    // xorshift64, cheap enough to call on the dequeue path
+    size_t randomPeer(SHARD& shard, size_t self) {
+        shard.rng ^= shard.rng << 13;
+        shard.rng ^= shard.rng >> 7;
+        shard.rng ^= shard.rng << 17;
+        size_t peer = shard.rng % (numShards - 1);
+        return peer >= self ? peer + 1 : peer; //never pick ourselves
+    }
+
+    // Moves up to `stealBatch` of `victim`'s smallest items into shard `self`,
+    // leaving `victim` at least half of its items unless `self` is empty and
+    // `victim` has only one
+    // Never holds both locks at once, so there is no lock ordering to get wrong
+    // Returns the number of items moved
+    size_t steal(size_t self, size_t victim, bool selfEmpty) {
+        stealsStarted.fetch_add(1);
+        vector<pair<T, int>> batch;
+        {
+            SHARD& from = shards[victim];
+            lock_guard<mutex> guard(from.lock);
+            size_t take = from.queue.size() / 2;
+            if (take == 0 && selfEmpty) { //a lone item is still worth taking when we have nothing
+                take = from.queue.size();
+            }
+            if (take > stealBatch) {
+                take = stealBatch;
+            }
+            batch.reserve(take);
+            while (batch.size() < take) {
+                int priority = from.queue.peek_priority();
+                batch.emplace_back(from.queue.dequeue(), priority);
+            }
+            publish(from);
+        }
+
+        if (!batch.empty()) {
+            SHARD& to = shards[self];
+            lock_guard<mutex> guard(to.lock);
+            for (auto& item : batch) {
+                to.queue.enqueue(item.first, item.second);
+            }
+            publish(to);
+        }
+        stealsDone.fetch_add(1);
+        return batch.size();
+    }
+
+    // Returns true if every shard was empty at once and no steal was moving
+    // items while it looked, so the queue really was empty
+    // Runs in O(S)     S = number of shards
+    bool allEmpty() {
+        size_t done = stealsDone.load();
+        for (size_t i = 0; i < numShards; i++) {
+            lock_guard<mutex> guard(shards[i].lock);
+            if (shards[i].queue.size() != 0) {
+                return false;
+            }
+        }
+        return stealsStarted.load() == done; //a steal started before `done` was read is still moving items
+    }
+
+    // One attempt at `dequeue`: steals if shard `self` is empty or a sampled peer
+    // is much better, then takes the local minimum
+    // Returns false if shard `self` was still empty
+    bool tryDequeue(size_t self, T& value, int& priority) {
+        SHARD& local = shards[self];
+
+        if (numShards > 1) {
+            if (local.count.load(memory_order_relaxed) == 0) {
+                size_t start = (randomPeer(local, self) + numShards - self - 1) % numShards; //offset past `self`
+                for (size_t i = 0; i < numShards - 1; i++) { //try every peer once until one has work
+                    size_t victim = (self + 1 + (start + i) % (numShards - 1)) % numShards;
+                    if (shards[victim].count.load(memory_order_relaxed) != 0 && steal(self, victim, true) != 0) {
+                        break;
+                    }
+                }
+            }
+            else if (++local.sinceSample >= sampleInterval) {
+                local.sinceSample = 0;
+                size_t victim = randomPeer(local, self);
+                long long localMin = local.minPriority.load(memory_order_relaxed);
+                long long peerMin = shards[victim].minPriority.load(memory_order_relaxed);
+                if (localMin - peerMin > stealThreshold) {
+                    steal(self, victim, false);
+                }
+            }
+        }
+
+        lock_guard<mutex> guard(local.lock);
+        if (local.queue.size() == 0) {
+            return false;
+        }
+        priority = local.queue.peek_priority();
+        value = local.queue.dequeue();
+        publish(local);
+        return true;
+    }
+
+public:
+    // Creates `shards` empty shards, normally one per worker thread
+    // `stealBatch` caps how many items one steal moves
+    // `stealThreshold` is how much worse (larger) the local minimum must be
+    // than a peer's before stealing from a non-empty shard
+    // `sampleInterval` is how many local dequeues happen between peer samples
+    // Runs in O(S)     S = number of shards
+    sharded_prqueue(size_t shards, size_t stealBatch = 32, int stealThreshold = 64, size_t sampleInterval = 32)
+        : shards(new SHARD[shards == 0 ? 1 : shards]),
+          numShards(shards == 0 ? 1 : shards),
+          stealBatch(stealBatch == 0 ? 1 : stealBatch),
+          stealThreshold(stealThreshold),
+          sampleInterval(sampleInterval == 0 ? 1 : sampleInterval) {
+        for (size_t i = 0; i < numShards; i++) {
+            this->shards[i].rng = 0x9E3779B97F4A7C15ULL * (i + 1);
+        }
+    }
+
+    sharded_prqueue(const sharded_prqueue&) = delete;
+    sharded_prqueue& operator=(const sharded_prqueue&) = delete;
+
+    // Returns the number of shards
+    // Runs in O(1)
+    size_t shard_count() const {
+        return numShards;
+    }
+
+    // Adds `value` to shard `shard` with the given `priority`
+    // Runs in O(H + M)  H = height of the shard's tree, and M = number of duplicate priorities
+    void enqueue(size_t shard, T value, int priority) {
+        SHARD& local = shards[shard % numShards];
+        lock_guard<mutex> guard(local.lock);
+        local.queue.enqueue(value, priority);
+        publish(local);
+    }
+
+    // Removes the value with the smallest priority in shard `shard` and returns
+    // it and its priority by reference, stealing from a peer first if the shard
+    // is empty or a sampled peer has a much better minimum
+    // Returns true if reference parameters were set, and false only if the whole
+    // queue was empty at some point during the call
+    // Runs in O(H + M) without a steal, O(S + B * (H + M)) with one    S = number of shards B = steal batch
+    // An empty shard also costs O(S) to confirm the queue is empty, repeated while steals overlap it
+    bool dequeue(size_t shard, T& value, int& priority) {
+        size_t self = shard % numShards;
+        while (true) {
+            if (tryDequeue(self, value, priority)) {
+                return true;
+            }
+            if (numShards == 1 || allEmpty()) {
+                return false;
+            }
+        }
+    }
+
+    // Returns the number of elements across all shards
+    // Only exact when no other thread is modifying the queue
+    // Runs in O(S)     S = number of shards
+    size_t size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < numShards; i++) {
+            total += shards[i].count.load(memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // Returns the number of elements in shard `shard`
+    // Runs in O(1)
+    size_t shard_size(size_t shard) const {
+        return shards[shard % numShards].count.load(memory_order_relaxed);
+    }
+
+    // Empties every shard
+    // Runs in O(N)
+    void clear() {
+        for (size_t i = 0; i < numShards; i++) {
+            lock_guard<mutex> guard(shards[i].lock);
+            shards[i].queue.clear();
+            publish(shards[i]);
+        }
+    }
+};
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <climits>  // For INT_MAX
+#include <sstream>  // For as_string
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "prqueue.h"
+
+using namespace std;
+
+// `prqueue` front-end for queues that are usually tiny. The first `N`
+// elements are kept inline, priorities and values in separate arrays, in
+// insertion order; the smallest priority is found with a vectorized scan.
+// Only when an enqueue would exceed `N` do the elements move into a
+// `prqueue`, and they stay there until it drains, so small queues never
+// touch the allocator.
+template <typename T, size_t N = 32>
+class small_prqueue {
+    static_assert(N > 0 && N % 8 == 0 && N <= 256, "small_prqueue: N must be a multiple of 8 no larger than 256");
+
+private:
+    alignas(32) int priorities[N];  // INT_MAX past `count`, so the scan never needs a tail loop
+    T values[N];
+    size_t count;
+    prqueue<T> tree;                // Holds every element once the queue has spilled
+
+    // Utility state for begin and next on the inline elements.
+    unsigned char order[N];
+    size_t pos;
+
+    // Returns the index of the first (oldest) element with the smallest priority
+    // Runs in O(N)
+    size_t minIndex() const {
+#if defined(__AVX2__)
+        __m256i best = _mm256_set1_epi32(INT_MAX);
+        for (size_t i = 0; i < N; i += 8) {
+            best = _mm256_min_epi32(best, _mm256_load_si256((const __m256i*)(priorities + i)));
+        }
+        __m128i half = _mm_min_epi32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+        half = _mm_min_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+        half = _mm_min_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m256i target = _mm256_set1_epi32(_mm_cvtsi128_si32(half));
+        for (size_t i = 0; i < N; i += 8) {
+            __m256i eq = _mm256_cmpeq_epi32(target, _mm256_load_si256((const __m256i*)(priorities + i)));
+            int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+            if (mask) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+        return 0;
+#elif defined(__SSE2__)
+        // SSE2 has no signed 32-bit min, so select with a compare mask
+        __m128i best = _mm_set1_epi32(INT_MAX);
+        for (size_t i = 0; i < N; i += 4) {
+            __m128i v = _mm_load_si128((const __m128i*)(priorities + i));
+            __m128i smaller = _mm_cmplt_epi32(v, best);
+            best = _mm_or_si128(_mm_and_si128(smaller, v), _mm_andnot_si128(smaller, best));
+        }
+        alignas(16) int lanes[4];
+        _mm_store_si128((__m128i*)lanes, best);
+        int low = lanes[0];
+        for (int lane = 1; lane < 4; lane++) {
+            if (lanes[lane] < low) {
+                low = lanes[lane];
+            }
+        }
+        __m128i target = _mm_set1_epi32(low);
+        for (size_t i = 0; i < N; i += 4) {
+            __m128i eq = _mm_cmpeq_epi32(target, _mm_load_si128((const __m128i*)(priorities + i)));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+            if (mask) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+        return 0;
+#else
+        size_t best = 0;
+        for (size_t i = 1; i < count; i++) {
+            if (priorities[i] < priorities[best]) {
+                best = i;
+            }
+        }
+        return best;
+#endif
+    }
+
+    // Moves every inline element into `tree`, oldest first so duplicates keep their order
+    void spill() {
+        for (size_t i = 0; i < count; i++) {
+            tree.enqueue(values[i], priorities[i]);
+            priorities[i] = INT_MAX;
+            values[i] = T{};
+        }
+        count = 0;
+    }
+
+    // Fills `order` with the inline indices sorted by priority, oldest first among duplicates
+    void sortInline(unsigned char* order) const {
+        for (size_t i = 0; i < count; i++) {
+            size_t j = i;
+            while (j > 0 && priorities[order[j - 1]] > priorities[i]) { //insertion sort, stable
+                order[j] = order[j - 1];
+                j--;
+            }
+            order[j] = (unsigned char)i;
+        }
+    }
+
+public:
+    // Creates an empty `small_prqueue`
+    // Runs in O(N)     N = inline capacity
+    small_prqueue() {
+        for (size_t i = 0; i < N; i++) {
+            priorities[i] = INT_MAX;
+        }
+        count = 0;
+        pos = 0;
+    }
+
+    // Empties the `small_prqueue`, freeing all memory it controls.
+    // Runs in O(N)
+    void clear() {
+        for (size_t i = 0; i < count; i++) {
+            priorities[i] = INT_MAX;
+            values[i] = T{};
+        }
+        count = 0;
+        pos = 0;
+        tree.clear();
+    }
+
+    // Returns true if the elements currently live in the `prqueue` rather than inline
+    // Runs in O(1)
+    bool spilled() const {
+        return tree.size() != 0;
+    }
+
+    // Adds `value` to the `small_prqueue` with the given `priority`
+    // Runs in O(1) inline, O(N) on the enqueue that spills, and O(H + M) once spilled
+    void enqueue(T value, int priority) {
+        if (spilled()) {
+            tree.enqueue(value, priority);
+            return;
+        }
+        if (count == N) {
+            spill();
+            tree.enqueue(value, priority);
+            return;
+        }
+        priorities[count] = priority;
+        values[count] = value;
+        count++;
+    }
+
+    // Returns value with the smallest priority in the `small_prqueue`
+    // Does not modify the `small_prqueue`
+    // If `small_prqueue` is empty, returns the default value for `T`
+    // Runs in O(N) inline, O(H) once spilled
+    T peek() const {
+        if (spilled()) {
+            return tree.peek();
+        }
+        if (count == 0) {
+            return T{};
+        }
+        return values[minIndex()];
+    }
+
+    // Returns the smallest priority in the `small_prqueue`
+    // If `small_prqueue` is empty, returns the default value for `int`
+    // Runs in O(N) inline, O(H) once spilled
+    int peek_priority() const {
+        if (spilled()) {
+            return tree.peek_priority();
+        }
+        if (count == 0) {
+            return int{};
+        }
+        return priorities[minIndex()];
+    }
+
+    // Returns value with the smallest priority in the `small_prqueue`
+    // Removes it from the `small_prqueue`
+    // If the `small_prqueue` is empty, returns the default value for `T`
+    // Runs in O(N) inline, O(H + M) once spilled
+    T dequeue() {
+        if (spilled()) {
+            return tree.dequeue();
+        }
+        if (count == 0) {
+            return T{};
+        }
+
+        size_t index = minIndex();
+        T returnValue = values[index];
+        for (size_t i = index + 1; i < count; i++) { //shift down to keep insertion order for dupes
+            priorities[i - 1] = priorities[i];
+            values[i - 1] = values[i];
+        }
+        count--;
+        priorities[count] = INT_MAX;
+        values[count] = T{};
+        return returnValue;
+    }
+
+    // Returns the number of elements in the `small_prqueue`
+    // Runs in O(1)
+    size_t size() const {
+        return spilled() ? tree.size() : count;
+    }
+
+    // Resets internal state for an in-order traversal
+    // Runs in O(N^2) inline, O(H) once spilled
+    void begin() {
+        pos = 0;
+        if (spilled()) {
+            tree.begin();
+        }
+        else {
+            sortInline(order);
+        }
+    }
+
+    // Uses internal state to return next in-order value and priority
+    // by reference and advances the internal state
+    // Returns true if reference parameters were set, and false otherwise
+    // Runs in O(1) inline, O(H + M) once spilled
+    bool next(T& value, int& priority) {
+        if (spilled()) {
+            return tree.next(value, priority);
+        }
+        if (pos >= count) {
+            return false;
+        }
+        value = values[order[pos]];
+        priority = priorities[order[pos]];
+        pos++;
+        return true;
+    }
+
+    // Converts the `small_prqueue` to a string representation in priority order
+    // Runs in O(N) once spilled, O(N^2) inline
+    string as_string() const {
+        if (spilled()) {
+            return tree.as_string();
+        }
+        ostringstream oss;
+        unsigned char order[N];
+        sortInline(order);
+        for (size_t i = 0; i < count; i++) {
+            oss << priorities[order[i]] << " value: " << values[order[i]] << endl;
+        }
+        return oss.str();
+    }
+};
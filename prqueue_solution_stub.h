@@ -7,7 +7,7 @@
 
 using namespace std;
 
-template <typename T>
+template <typename T, bool Hashed = false>
 class prqueue {
    private:
     struct NODE {
@@ -48,7 +48,9 @@ class prqueue {
     ~prqueue();
 
     // Adds `value` to the `prqueue` with the given `priority`
-    // Runs in O(H + M)  H = height of the tree, and M = number of duplicate priorities
+    // Ends any unfinished begin()/next() traversal
+    // Runs in O(H + M)  H = height of the tree, and M = number of duplicate priorities,
+    // plus O(N) if a traversal was left unfinished
     void enqueue(T value, int priority);
 
     // Returns value with the smallest priority in the `prqueue` 
@@ -57,10 +59,18 @@ class prqueue {
     // Runs in O(H + M)     H = height of the tree M = the number of duplicate priorities
     T peek() const;
 
+    // Returns the smallest priority in the `prqueue`
+    // Does not modify the `prqueue`
+    // If `prqueue` is empty, returns the default value for `int`
+    // Runs in O(H)     H = height of the tree
+    int peek_priority() const;
+
     // Returns value with the smallest priority in the `prqueue` 
     // Removes it from the `prqueue
     // If the `prqueue` is empty, returns the default value for `T`
-    // Runs in O(H + M)     H = height of the tree M = number of duplicate priorities
+    // Ends any unfinished begin()/next() traversal
+    // Runs in O(H + M)     H = height of the tree M = number of duplicate priorities,
+    // plus O(N) if a traversal was left unfinished
     T dequeue();
 
     // Returns the number of elements in the `prqueue`
@@ -82,10 +92,39 @@ class prqueue {
     string as_string() const;
 
     // Checks if the contents of `this` and `other` are equivalent ie they have the same priorities,
-    // values, and same internal tree structure
-    // Runs in O(N) time, where N is the maximum number of nodes either `prqueue`
+    // values, same duplicate lists, and same internal tree structure
+    // Runs in O(1) when the sizes (or, if `Hashed`, the content hashes) differ,
+    // otherwise O(N) time, where N is the number of values in `this`
     bool operator==(const prqueue& other) const;
 
+    // Returns a hash of the priorities and values in the `prqueue`, independent of
+    // tree shape; equal queues always have equal hashes. Only with `Hashed` set
+    // Runs in O(1)
+    size_t content_hash() const requires Hashed;
+
+    // Parallel `operator=` for very large queues: copies the top levels of
+    // `other` serially, then copies the subtrees below them on `threads`
+    // threads (0 = one per core), each thread allocating its own nodes
+    // Runs in O(N + O) work, about O((N + O) / P) time on P threads for balanced trees
+    void assign_parallel(const prqueue& other, unsigned threads = 0);
+
+    // Parallel `clear`: frees the subtrees below the top levels on `threads`
+    // threads (0 = one per core), then the top levels
+    // Runs in O(N) work, about O(N / P) time on P threads for balanced trees
+    void clear_parallel(unsigned threads = 0);
+
+    // Parallel `operator==`: compares the top levels serially, then the
+    // subtree pairs below them on `threads` threads (0 = one per core),
+    // skipping remaining pairs once one differs
+    // Runs in O(N) work, about O(N / P) time on P threads for balanced trees
+    bool equal_parallel(const prqueue& other, unsigned threads = 0) const;
+
+    // Parallel `as_string`: formats the subtrees below the top levels into
+    // separate chunks on `threads` threads (0 = one per core), then
+    // concatenates the chunks in priority order
+    // Runs in O(N) work, about O(N / P) time on P threads for balanced trees
+    string as_string_parallel(unsigned threads = 0) const;
+
     // Returns a pointer to root node of the BST
     // Runs in O(1)
     void* getRoot() {
@@ -1,4 +1,14 @@
 #include "prqueue.h"
+#include "prqueue_compact.h"
+#include "prqueue_external.h"
+#include "prqueue_persistent.h"
+#include "prqueue_sharded.h"
+#include "prqueue_small.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -156,6 +166,30 @@ TEST(prqueue, next_func) {
 }
 
 
+TEST(prqueue, dequeue_after_begin) {
+    prqueue<int> queue;
+    queue.enqueue(1, 1);
+    queue.begin();
+    EXPECT_EQ(queue.dequeue(), 1); //the traversal still pointed at this node
+    EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(prqueue, drain_after_partial_traversal) {
+    prqueue<int> queue;
+    queue.enqueue(5, 5);
+    queue.enqueue(8, 8);
+    queue.begin();
+    int value;
+    int priority;
+    EXPECT_TRUE(queue.next(value, priority));
+    EXPECT_EQ(value, 5);
+    while (queue.size()) {
+        queue.dequeue();
+    }
+    queue.enqueue(3, 3);
+    EXPECT_EQ(queue.as_string(), "3 value: 3\n");
+}
+
 TEST(prqueue, copy_constuctor_func) {
     prqueue<int> queue;
     queue.enqueue(10, 1);
@@ -269,3 +303,685 @@ TEST(queue, in_order_traversal_dupes) {
     EXPECT_EQ(str, "10 20 30 35 40 50 ");
 }
 
+
+TEST(sharded_prqueue, local_order) {
+    sharded_prqueue<int> queue(2);
+    queue.enqueue(0, 30, 3);
+    queue.enqueue(0, 10, 1);
+    queue.enqueue(0, 20, 2);
+    EXPECT_EQ(queue.size(), 3);
+    EXPECT_EQ(queue.shard_size(0), 3);
+    EXPECT_EQ(queue.shard_size(1), 0);
+
+    int value;
+    int priority;
+    EXPECT_TRUE(queue.dequeue(0, value, priority));
+    EXPECT_EQ(value, 10);
+    EXPECT_EQ(priority, 1);
+    EXPECT_TRUE(queue.dequeue(0, value, priority));
+    EXPECT_EQ(value, 20);
+    EXPECT_TRUE(queue.dequeue(0, value, priority));
+    EXPECT_EQ(value, 30);
+    EXPECT_FALSE(queue.dequeue(0, value, priority));
+}
+
+TEST(sharded_prqueue, steal_when_empty) {
+    sharded_prqueue<int> queue(2, 4);
+    for (int i = 1; i <= 10; i++) {
+        queue.enqueue(0, i * 10, i);
+    }
+
+    int value;
+    int priority;
+    EXPECT_TRUE(queue.dequeue(1, value, priority));
+    EXPECT_EQ(value, 10); //the thief gets the victim's smallest items
+    EXPECT_EQ(queue.shard_size(1), 3);
+    EXPECT_EQ(queue.shard_size(0), 6);
+}
+
+TEST(sharded_prqueue, steal_leaves_victim_half) {
+    sharded_prqueue<int> queue(2);
+    queue.enqueue(0, 10, 1);
+    queue.enqueue(0, 20, 2);
+    queue.enqueue(0, 30, 3);
+
+    int value;
+    int priority;
+    EXPECT_TRUE(queue.dequeue(1, value, priority));
+    EXPECT_EQ(value, 10);
+    EXPECT_EQ(queue.shard_size(0), 2); //three items: one stolen, two left
+
+    queue.clear();
+    queue.enqueue(0, 40, 4);
+    EXPECT_TRUE(queue.dequeue(1, value, priority)); //an empty thief still takes a lone item
+    EXPECT_EQ(value, 40);
+    EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(sharded_prqueue, steal_when_peer_much_better) {
+    sharded_prqueue<int> queue(2, 4, 10, 1);
+    queue.enqueue(0, 1000, 100);
+    queue.enqueue(0, 1001, 101);
+    queue.enqueue(1, 10, 1);
+    queue.enqueue(1, 20, 2);
+
+    int value;
+    int priority;
+    EXPECT_TRUE(queue.dequeue(0, value, priority));
+    EXPECT_EQ(value, 10);
+    EXPECT_EQ(priority, 1);
+}
+
+// Gives up the CPU whenever it is copied, so a steal is likely to be
+// interrupted while its batch is in neither shard
+struct YIELDING {
+    int value = 0;
+    YIELDING() = default;
+    YIELDING(int value) : value(value) {
+    }
+    YIELDING(const YIELDING& other) : value(other.value) {
+        this_thread::yield();
+    }
+    YIELDING& operator=(const YIELDING& other) {
+        value = other.value;
+        this_thread::yield();
+        return *this;
+    }
+};
+
+TEST(sharded_prqueue, empty_only_when_drained) {
+    // Every item starts in shard 0 and steals keep small batches in flight,
+    // so a dequeue that missed an in-flight batch would return false too early
+    const int threads = 8;
+    const int items = 500;
+    for (int round = 0; round < 40; round++) {
+        sharded_prqueue<YIELDING> queue(threads, 2, 64, 1);
+        for (int i = 0; i < items; i++) {
+            queue.enqueue(0, i, i % 31);
+        }
+
+        atomic<int> taken{0};
+        vector<size_t> leftAtFalse(threads, 0);
+        vector<thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                YIELDING value;
+                int priority;
+                while (queue.dequeue(t, value, priority)) {
+                    taken++;
+                }
+                leftAtFalse[t] = queue.size(); //nothing is enqueued, so an empty queue stays empty
+            });
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+        EXPECT_EQ(taken.load(), items);
+        for (int t = 0; t < threads; t++) {
+            EXPECT_EQ(leftAtFalse[t], 0) << "thread " << t;
+        }
+    }
+}
+
+TEST(sharded_prqueue, concurrent_drain_loses_nothing) {
+    const int threads = 4;
+    const int perThread = 5000;
+    sharded_prqueue<int> queue(threads);
+    vector<thread> workers;
+    vector<long long> sums(threads, 0);
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < perThread; i++) {
+                queue.enqueue(t, t * perThread + i, i % 97);
+            }
+            int value;
+            int priority;
+            while (queue.dequeue(t, value, priority)) {
+                sums[t] += value;
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    long long total = 0;
+    for (long long s : sums) {
+        total += s;
+    }
+    long long n = threads * perThread;
+    EXPECT_EQ(total, n * (n - 1) / 2);
+    EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(compact_prqueue, dequeue_order_with_dupes) {
+    compact_prqueue<int> queue;
+    EXPECT_EQ(queue.dequeue(), 0);
+    queue.enqueue(50, 5);
+    queue.enqueue(20, 2);
+    queue.enqueue(80, 8);
+    queue.enqueue(25, 2);
+    queue.enqueue(10, 1);
+    queue.enqueue(70, 7);
+    EXPECT_EQ(queue.size(), 6);
+    EXPECT_EQ(queue.peek(), 10);
+    EXPECT_EQ(queue.peek_priority(), 1);
+    EXPECT_EQ(queue.as_string(), "1 value: 10\n" "2 value: 20\n" "2 value: 25\n" "5 value: 50\n" "7 value: 70\n" "8 value: 80\n");
+
+    EXPECT_EQ(queue.dequeue(), 10);
+    EXPECT_EQ(queue.dequeue(), 20);
+    EXPECT_EQ(queue.dequeue(), 25);
+    queue.enqueue(30, 3); //reuses a freed slot
+    EXPECT_EQ(queue.dequeue(), 30);
+    EXPECT_EQ(queue.dequeue(), 50);
+    EXPECT_EQ(queue.dequeue(), 70);
+    EXPECT_EQ(queue.dequeue(), 80);
+    EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(compact_prqueue, matches_prqueue) {
+    prqueue<int> pointers;
+    compact_prqueue<int> compact;
+    unsigned seed = 12345;
+    for (int i = 0; i < 2000; i++) {
+        seed = seed * 1103515245 + 12345;
+        int priority = (seed >> 16) % 100;
+        pointers.enqueue(i, priority);
+        compact.enqueue(i, priority);
+        if (i % 3 == 0) {
+            EXPECT_EQ(pointers.dequeue(), compact.dequeue());
+        }
+    }
+    EXPECT_EQ(pointers.as_string(), compact.as_string());
+    EXPECT_EQ(pointers.size(), compact.size());
+
+    compact.begin();
+    int value;
+    int priority;
+    size_t count = 0;
+    while (compact.next(value, priority)) {
+        count++;
+    }
+    EXPECT_EQ(count, compact.size());
+
+    compact_prqueue<int> copy = compact;
+    EXPECT_TRUE(copy == compact);
+    copy.dequeue();
+    EXPECT_FALSE(copy == compact);
+
+    while (pointers.size() > 0) {
+        EXPECT_EQ(pointers.dequeue(), compact.dequeue());
+    }
+    compact.clear();
+    EXPECT_EQ(compact.memory_bytes(), 0);
+}
+
+TEST(compact_prqueue, equal_compares_duplicate_lists) {
+    compact_prqueue<int> queue;
+    queue.enqueue(10, 1);
+    queue.enqueue(20, 2);
+    queue.enqueue(25, 2);
+
+    compact_prqueue<int> longer;
+    longer.enqueue(10, 1);
+    longer.enqueue(20, 2);
+    longer.enqueue(99, 2);
+    longer.enqueue(98, 2);
+    EXPECT_FALSE(queue == longer);
+    EXPECT_FALSE(longer == queue);
+
+    compact_prqueue<int> differentDupe;
+    differentDupe.enqueue(10, 1);
+    differentDupe.enqueue(20, 2);
+    differentDupe.enqueue(26, 2);
+    EXPECT_FALSE(queue == differentDupe);
+
+    compact_prqueue<int> copy = queue;
+    EXPECT_TRUE(copy == queue);
+}
+
+TEST(compact_prqueue, grows_across_blocks) {
+    compact_prqueue<int> queue;
+    for (int i = 0; i < 10000; i++) { //spans several blocks
+        queue.enqueue(i, (i * 7919) % 10007);
+    }
+    size_t bytes = queue.memory_bytes();
+    EXPECT_LT(bytes, 10000 * 20 + 1024 * 20 + 256); //at most one partly used block
+
+    compact_prqueue<int> copy(queue);
+    EXPECT_TRUE(copy == queue);
+    compact_prqueue<int> assigned;
+    assigned.enqueue(1, 1);
+    assigned = queue;
+    EXPECT_TRUE(assigned == queue);
+
+    int last = -1;
+    for (int i = 0; i < 10000; i++) {
+        int priority = queue.peek_priority();
+        EXPECT_LE(last, priority);
+        last = priority;
+        EXPECT_EQ(queue.dequeue(), copy.dequeue());
+    }
+    EXPECT_EQ(queue.size(), 0);
+    EXPECT_EQ(assigned.size(), 10000);
+}
+
+TEST(small_prqueue, inline_order_with_dupes) {
+    small_prqueue<int, 8> queue;
+    EXPECT_EQ(queue.dequeue(), 0);
+    queue.enqueue(50, 5);
+    queue.enqueue(20, 2);
+    queue.enqueue(25, 2);
+    queue.enqueue(10, 1);
+    EXPECT_FALSE(queue.spilled());
+    EXPECT_EQ(queue.size(), 4);
+    EXPECT_EQ(queue.peek(), 10);
+    EXPECT_EQ(queue.peek_priority(), 1);
+    EXPECT_EQ(queue.as_string(), "1 value: 10\n" "2 value: 20\n" "2 value: 25\n" "5 value: 50\n");
+
+    queue.begin();
+    int value;
+    int priority;
+    string str;
+    while (queue.next(value, priority)) {
+        str += to_string(value) + " ";
+    }
+    EXPECT_EQ(str, "10 20 25 50 ");
+
+    EXPECT_EQ(queue.dequeue(), 10);
+    EXPECT_EQ(queue.dequeue(), 20);
+    EXPECT_EQ(queue.dequeue(), 25);
+    EXPECT_EQ(queue.dequeue(), 50);
+    EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(small_prqueue, spills_and_returns_inline) {
+    small_prqueue<int, 8> queue;
+    prqueue<int> expected;
+    for (int i = 0; i < 20; i++) {
+        queue.enqueue(i, (i * 7) % 5);
+        expected.enqueue(i, (i * 7) % 5);
+        EXPECT_EQ(queue.spilled(), i >= 8);
+    }
+    EXPECT_EQ(queue.as_string(), expected.as_string());
+    while (expected.size() > 0) {
+        EXPECT_EQ(queue.dequeue(), expected.dequeue());
+    }
+    EXPECT_FALSE(queue.spilled());
+
+    queue.enqueue(7, 7);
+    EXPECT_FALSE(queue.spilled());
+    EXPECT_EQ(queue.peek(), 7);
+}
+
+TEST(external_prqueue, ten_times_memory_budget) {
+    const size_t budget = 1000;
+    const int items = 10 * budget;
+    string dir = (filesystem::temp_directory_path() / "prqueue_external_test").string();
+
+    // Reference order: by priority, then by enqueue order
+    vector<pair<int, int>> expected;
+    {
+        external_prqueue<int> queue(dir, budget, 64, 8);
+        unsigned seed = 99;
+        size_t maxRuns = 0;
+        for (int i = 0; i < items; i++) {
+            seed = seed * 1103515245 + 12345;
+            int priority = (seed >> 16) % 500;
+            queue.enqueue(i, priority);
+            expected.emplace_back(priority, i);
+            EXPECT_LE(queue.memory_size(), budget);
+            maxRuns = max(maxRuns, queue.run_count());
+        }
+        EXPECT_EQ(queue.size(), items);
+        EXPECT_GT(maxRuns, 0);
+        EXPECT_LE(maxRuns, 9);
+
+        stable_sort(expected.begin(), expected.end(), [](const pair<int, int>& a, const pair<int, int>& b) {
+            return a.first < b.first;
+        });
+        for (int i = 0; i < items; i++) {
+            EXPECT_EQ(queue.peek(), expected[i].second);
+            ASSERT_EQ(queue.dequeue(), expected[i].second);
+        }
+        EXPECT_EQ(queue.size(), 0);
+        EXPECT_EQ(queue.run_count(), 0);
+        EXPECT_EQ(queue.dequeue(), 0);
+    }
+    EXPECT_TRUE(filesystem::is_empty(dir));
+    filesystem::remove_all(dir);
+}
+
+TEST(external_prqueue, failed_spill_keeps_every_item) {
+    string dir = (filesystem::temp_directory_path() / "prqueue_external_test_failed").string();
+    {
+        external_prqueue<int> queue(dir, 8, 4, 4);
+        filesystem::remove_all(dir); //the first spill now cannot create its run file
+
+        int enqueued = 0;
+        bool threw = false;
+        for (int i = 0; i < 20 && !threw; i++) {
+            try {
+                queue.enqueue(i, 100 - i);
+                enqueued++;
+            }
+            catch (const runtime_error&) {
+                threw = true;
+            }
+        }
+        EXPECT_TRUE(threw);
+        EXPECT_EQ(enqueued, 8);
+        EXPECT_EQ(queue.size(), 8);
+        EXPECT_EQ(queue.memory_size(), 8);
+        EXPECT_EQ(queue.run_count(), 0);
+        for (int i = 7; i >= 0; i--) {
+            EXPECT_EQ(queue.dequeue(), i);
+        }
+        EXPECT_EQ(queue.size(), 0);
+    }
+    filesystem::remove_all(dir);
+}
+
+TEST(external_prqueue, queues_sharing_a_directory) {
+    string dir = (filesystem::temp_directory_path() / "prqueue_external_test_shared").string();
+    {
+        external_prqueue<int> first(dir, 8, 4, 4);
+        external_prqueue<int> second(dir, 8, 4, 4);
+        for (int i = 0; i < 100; i++) { //both spill, into separate run files
+            first.enqueue(i, i % 13);
+            second.enqueue(-i, i % 13);
+        }
+        EXPECT_GT(first.run_count(), 0);
+        EXPECT_GT(second.run_count(), 0);
+
+        prqueue<int> expectedFirst;
+        prqueue<int> expectedSecond;
+        for (int i = 0; i < 100; i++) {
+            expectedFirst.enqueue(i, i % 13);
+            expectedSecond.enqueue(-i, i % 13);
+        }
+        while (expectedFirst.size() > 0) {
+            EXPECT_EQ(first.dequeue(), expectedFirst.dequeue());
+            EXPECT_EQ(second.dequeue(), expectedSecond.dequeue());
+        }
+    }
+    EXPECT_TRUE(filesystem::is_empty(dir));
+    filesystem::remove_all(dir);
+}
+
+TEST(external_prqueue, merges_rewrite_each_record_few_times) {
+    string dir = (filesystem::temp_directory_path() / "prqueue_external_test_merges").string();
+    {
+        const int items = 40000;
+        external_prqueue<int> queue(dir, 100, 16, 16);
+        prqueue<int> expected;
+        unsigned seed = 7;
+        for (int i = 0; i < items; i++) {
+            seed = seed * 1103515245 + 12345;
+            int priority = (seed >> 16) % 10000;
+            queue.enqueue(i, priority);
+            expected.enqueue(i, priority);
+            EXPECT_LE(queue.run_count(), 16);
+        }
+        // Spills alone write about `items` records over 800 spills; merging
+        // every run each time would write about 25 times that
+        EXPECT_LE(queue.records_written(), 6ull * items);
+
+        while (expected.size() > 0) {
+            ASSERT_EQ(queue.dequeue(), expected.dequeue());
+        }
+        EXPECT_EQ(queue.run_count(), 0);
+    }
+    filesystem::remove_all(dir);
+}
+
+TEST(external_prqueue, interleaved_with_small_priorities) {
+    string dir = (filesystem::temp_directory_path() / "prqueue_external_test_interleaved").string();
+    {
+        external_prqueue<int> queue(dir, 16, 4, 4);
+        prqueue<int> expected;
+        for (int i = 0; i < 500; i++) {
+            int priority = (i * 37) % 101;
+            queue.enqueue(i, priority);
+            expected.enqueue(i, priority);
+            if (i % 4 == 3) { //newer items can beat ones already on disk
+                EXPECT_EQ(queue.dequeue(), expected.dequeue());
+            }
+        }
+        while (expected.size() > 0) {
+            EXPECT_EQ(queue.dequeue(), expected.dequeue());
+        }
+        EXPECT_EQ(queue.size(), 0);
+    }
+    filesystem::remove_all(dir);
+}
+
+TEST(persistent_prqueue, copies_are_unaffected) {
+    persistent_prqueue<int> queue;
+    queue.enqueue(30, 3);
+    queue.enqueue(10, 1);
+    queue.enqueue(20, 2);
+    queue.enqueue(25, 2);
+
+    persistent_prqueue<int> copy = queue;
+    EXPECT_TRUE(copy == queue);
+    EXPECT_EQ(queue.dequeue(), 10);
+    EXPECT_EQ(queue.dequeue(), 20);
+    queue.enqueue(5, 0);
+    EXPECT_FALSE(copy == queue);
+
+    EXPECT_EQ(copy.size(), 4);
+    EXPECT_EQ(copy.as_string(), "1 value: 10\n" "2 value: 20\n" "2 value: 25\n" "3 value: 30\n");
+    EXPECT_EQ(queue.as_string(), "0 value: 5\n" "2 value: 25\n" "3 value: 30\n");
+
+    persistent_prqueue<int> assigned;
+    assigned = copy;
+    EXPECT_EQ(assigned.dequeue(), 10);
+    EXPECT_EQ(assigned.dequeue(), 20);
+    EXPECT_EQ(assigned.dequeue(), 25);
+    EXPECT_EQ(assigned.dequeue(), 30);
+    EXPECT_EQ(assigned.dequeue(), 0);
+    EXPECT_EQ(copy.peek(), 10);
+    EXPECT_EQ(copy.peek_priority(), 1);
+}
+
+TEST(persistent_prqueue, matches_prqueue) {
+    prqueue<int> expected;
+    persistent_prqueue<int> queue;
+    for (int i = 0; i < 1000; i++) {
+        int priority = (i * 53) % 61;
+        expected.enqueue(i, priority);
+        queue.enqueue(i, priority);
+        if (i % 5 == 0) {
+            EXPECT_EQ(queue.dequeue(), expected.dequeue());
+        }
+    }
+    EXPECT_EQ(queue.as_string(), expected.as_string());
+    while (expected.size() > 0) {
+        EXPECT_EQ(queue.dequeue(), expected.dequeue());
+    }
+}
+
+TEST(persistent_prqueue, iterate_snapshot_while_original_changes) {
+    persistent_prqueue<int> queue;
+    for (int i = 0; i < 2000; i++) {
+        queue.enqueue(i, (i * 31) % 1000);
+    }
+    persistent_prqueue<int> snapshot = queue.snapshot();
+
+    thread reader([&snapshot] {
+        for (int round = 0; round < 20; round++) {
+            snapshot.begin();
+            int value;
+            int priority;
+            int last = -1;
+            size_t count = 0;
+            while (snapshot.next(value, priority)) {
+                EXPECT_LE(last, priority);
+                last = priority;
+                count++;
+            }
+            EXPECT_EQ(count, 2000);
+        }
+    });
+    for (int i = 0; i < 5000; i++) {
+        queue.dequeue();
+        queue.enqueue(i, i % 1000);
+    }
+    reader.join();
+    EXPECT_EQ(snapshot.size(), 2000);
+}
+
+TEST(persistent_prqueue, monotonic_and_equal_priorities) {
+    // Each of these would make a search tree one long path; the heap keeps every operation O(log N)
+    const int items = 100000;
+    persistent_prqueue<int> ascending;
+    persistent_prqueue<int> descending;
+    persistent_prqueue<int> equal;
+    for (int i = 0; i < items; i++) {
+        ascending.enqueue(i, i);
+        descending.enqueue(i, items - i);
+        equal.enqueue(i, 7);
+    }
+    persistent_prqueue<int> snapshot = ascending;
+
+    for (int i = 0; i < items; i++) {
+        ASSERT_EQ(ascending.dequeue(), i);
+        ASSERT_EQ(descending.dequeue(), items - 1 - i);
+        ASSERT_EQ(equal.dequeue(), i); //oldest first among equal priorities
+    }
+    EXPECT_EQ(snapshot.size(), items);
+    EXPECT_EQ(snapshot.peek(), 0);
+    snapshot.clear();
+    EXPECT_EQ(snapshot.size(), 0);
+}
+
+// Outlives the test and is destroyed at exit, after this thread's thread-locals
+persistent_prqueue<int> staticQueue;
+
+TEST(persistent_prqueue, static_queue_freed_at_exit) {
+    for (int i = 0; i < 1000; i++) {
+        staticQueue.enqueue(i, i);
+    }
+    persistent_prqueue<int> local = staticQueue;
+    EXPECT_EQ(local.dequeue(), 0);
+    EXPECT_EQ(staticQueue.size(), 1000);
+}
+
+TEST(persistent_prqueue, drop_shared_chain_on_two_threads) {
+    // Descending priorities put every node on one left path, so freeing it recursively would overflow the stack
+    const int items = 200000;
+    for (int round = 0; round < 4; round++) {
+        persistent_prqueue<int> queue;
+        for (int i = 0; i < items; i++) {
+            queue.enqueue(i, items - i);
+        }
+        persistent_prqueue<int> snapshot = queue.snapshot();
+
+        thread other([&snapshot] { snapshot.clear(); });
+        queue.clear();
+        other.join();
+        EXPECT_EQ(queue.size(), 0);
+        EXPECT_EQ(snapshot.size(), 0);
+    }
+}
+
+TEST(prqueue, parallel_bulk_operations) {
+    prqueue<int> queue;
+    unsigned seed = 2024;
+    for (int i = 0; i < 5000; i++) {
+        seed = seed * 1103515245 + 12345;
+        queue.enqueue(i, (seed >> 16) % 1500);
+    }
+
+    prqueue<int> copy;
+    copy.enqueue(1, 1);
+    copy.assign_parallel(queue, 4);
+    EXPECT_EQ(copy.size(), queue.size());
+    EXPECT_TRUE(copy == queue);
+    EXPECT_TRUE(copy.equal_parallel(queue, 4));
+    EXPECT_EQ(queue.as_string_parallel(4), queue.as_string());
+    EXPECT_EQ(copy.as_string_parallel(3), queue.as_string());
+
+    copy.dequeue();
+    copy.enqueue(-1, 100000);
+    EXPECT_FALSE(copy.equal_parallel(queue, 4));
+
+    queue.dequeue();
+    while (queue.size() > 0) {
+        EXPECT_EQ(queue.dequeue(), copy.dequeue());
+    }
+    EXPECT_EQ(copy.size(), 1);
+    copy.clear_parallel(4);
+    EXPECT_EQ(copy.size(), 0);
+    EXPECT_EQ(copy.getRoot(), nullptr);
+    EXPECT_EQ(copy.as_string_parallel(4), "");
+}
+
+TEST(queue, equal_equals_operator_func_dupes) {
+    prqueue<int> queue;
+    queue.enqueue(10, 1);
+    queue.enqueue(20, 2);
+    queue.enqueue(25, 2);
+
+    prqueue<int> queueFrance;
+    queueFrance.enqueue(10, 1);
+    queueFrance.enqueue(20, 2);
+    queueFrance.enqueue(26, 2);
+    EXPECT_FALSE(queue == queueFrance); //differs only in the duplicate list
+    EXPECT_FALSE(queue.equal_parallel(queueFrance, 2));
+
+    prqueue<int> shorter;
+    shorter.enqueue(10, 1);
+    shorter.enqueue(20, 2);
+    EXPECT_FALSE(queue == shorter);
+    EXPECT_FALSE(shorter == queue);
+
+    prqueue<int> copy = queue;
+    EXPECT_TRUE(copy == queue);
+    EXPECT_TRUE(copy.equal_parallel(queue, 2));
+}
+
+TEST(queue, content_hash_tracks_contents) {
+    prqueue<int, true> queue;
+    EXPECT_EQ(queue.content_hash(), 0);
+    queue.enqueue(10, 1);
+    queue.enqueue(30, 3);
+    queue.enqueue(20, 2);
+
+    prqueue<int, true> reordered; //same contents, different tree shape
+    reordered.enqueue(20, 2);
+    reordered.enqueue(10, 1);
+    reordered.enqueue(30, 3);
+    EXPECT_EQ(queue.content_hash(), reordered.content_hash());
+    EXPECT_FALSE(queue == reordered);
+
+    reordered.dequeue();
+    EXPECT_NE(queue.content_hash(), reordered.content_hash());
+    reordered.enqueue(10, 1);
+    EXPECT_EQ(queue.content_hash(), reordered.content_hash());
+
+    prqueue<int, true> sameSize = queue; //same size, one value differs
+    sameSize.dequeue();
+    sameSize.enqueue(11, 1);
+    EXPECT_NE(queue.content_hash(), sameSize.content_hash());
+    EXPECT_FALSE(queue == sameSize);
+    EXPECT_FALSE(queue.equal_parallel(sameSize, 2));
+
+    queue.clear();
+    EXPECT_EQ(queue.content_hash(), 0);
+}
+
+TEST(queue, equal_equals_operator_deep_tree) {
+    prqueue<int> queue;
+    prqueue<int> queueFrance;
+    for (int i = 0; i < 20000; i++) { //ascending priorities build one long right spine
+        queue.enqueue(i, i);
+        queueFrance.enqueue(i, i);
+        if (i % 1000 == 0) {
+            queue.enqueue(i + 1, i);
+            queueFrance.enqueue(i + 1, i);
+        }
+    }
+    EXPECT_TRUE(queue == queueFrance);
+}